@@ -0,0 +1,391 @@
+/**
+ * EZLog benchmark suite for the native build (see doc/Benchmarks.md):
+ *    pio run -e native && .pio/build/native/program [--quick] [--list] [name-filter ...]
+ *
+ * Each case prints one JSON object per line to stdout (diagnostics go to stderr), f.e.
+ *    {"name":"log_emitted","threads":1,"calls":131072,"ns_per_call":410.5,"ns_min":402.8,"allocs_per_call":0.000,"bytes_per_call":71.0}
+ *
+ *    ns_per_call       median of the repetitions (contention: wall time / lines of all threads)
+ *    ns_min            fastest repetition
+ *    allocs_per_call   operator new per call (counted by host/HostHeap.cpp)
+ *    bytes_per_call    bytes written to Serial per call (filesink_*: into the file)
+ *    fs_writes_per_call  filesink_* only: write() calls to the filesystem per log call (counted by host/FS.h)
+ */
+#include <Arduino.h>
+#include "EZLog.h"
+#include "HostHeap.h"
+#include "LogFileSink.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include <string>
+
+// The tests (pio test -e native) are built together with src/ and bench/, they bring their own main()
+#ifndef PIO_UNIT_TESTING
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    constexpr int REPETITIONS = 5;
+    constexpr uint32_t CONTENTION_THREADS[] = {1, 2, 4, 8};
+
+    bool quick = false;
+
+    double elapsedNanos(const Clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    }
+
+    struct Result {
+        uint32_t threads = 1;
+        uint64_t calls = 0;
+        double nsPerCall = 0;
+        double nsMin = 0;
+        double allocsPerCall = 0;
+        double bytesPerCall = 0;
+        double fsWritesPerCall = -1;    // < 0: no file sink
+    };
+
+    void printResult(const char* name, const Result& result) {
+        printf("{\"name\":\"%s\",\"threads\":%u,\"calls\":%llu,\"ns_per_call\":%.1f,\"ns_min\":%.1f,"
+               "\"allocs_per_call\":%.3f,\"bytes_per_call\":%.1f",
+               name, static_cast<unsigned>(result.threads), static_cast<unsigned long long>(result.calls),
+               result.nsPerCall, result.nsMin, result.allocsPerCall, result.bytesPerCall);
+        if (result.fsWritesPerCall >= 0) printf(",\"fs_writes_per_call\":%.4f", result.fsWritesPerCall);
+        printf("}\n");
+        fflush(stdout);
+    }
+
+    // filesink_*: the filesystem and sink of the running case, bytes_per_call is taken from the file
+    fs::FS* benchFilesystem = nullptr;
+    FileSink* benchFileSink = nullptr;
+
+    unsigned long bytesWritten() {
+        return benchFileSink != nullptr ? benchFileSink->bytesWritten() : Serial.bytesWritten.load();
+    }
+
+    /**
+     * Runs body(count) with a growing count, until one run takes long enough, then REPETITIONS runs with this count.
+     * body is called once before (warm-up: instance of the task, callsites, filter decisions).
+     */
+    Result measure(void (*body)(uint32_t count)) {
+        const double targetNanos = quick ? 2e6 : 50e6;
+        body(16);
+
+        uint32_t count = 64;
+        while (true) {
+            const Clock::time_point start = Clock::now();
+            body(count);
+            const double nanos = elapsedNanos(start);
+            if (nanos >= targetNanos || count >= (1u << 26)) break;
+            count = nanos < targetNanos / 16 ? count * 16 : count * 2;
+        }
+
+        std::vector<double> runs;
+        const uint64_t allocsBefore = HostHeap::allocations();
+        const unsigned long bytesBefore = bytesWritten();
+        const uint32_t fsWritesBefore = benchFilesystem != nullptr ? benchFilesystem->writeCalls.load() : 0;
+        for (int i = 0; i < REPETITIONS; i++) {
+            const Clock::time_point start = Clock::now();
+            body(count);
+            runs.push_back(elapsedNanos(start) / count);
+        }
+        std::sort(runs.begin(), runs.end());
+
+        Result result;
+        result.calls = count;
+        result.nsPerCall = runs[REPETITIONS / 2];
+        result.nsMin = runs[0];
+        result.allocsPerCall = double(HostHeap::allocations() - allocsBefore) / (double(count) * REPETITIONS);
+        result.bytesPerCall = double(bytesWritten() - bytesBefore) / (double(count) * REPETITIONS);
+        if (benchFilesystem != nullptr) {
+            result.fsWritesPerCall = double(benchFilesystem->writeCalls.load() - fsWritesBefore) /
+                                     (double(count) * REPETITIONS);
+        }
+        return result;
+    }
+
+
+    /** ***************************************
+     *                 Cases
+     *************************************** */
+    LoggingConfig baseConfig() {
+        LoggingConfig config;
+        config.loglevel = Loglevel::DEBUG;
+        config.printStartEndMessages = false;
+        return config;
+    }
+
+    // Log calls at top level are never filtered, so each body opens a scope:
+    void logFiltered(const uint32_t count) {
+        EZ_LOG("Bench");
+        for (uint32_t i = 0; i < count; i++) Log::verboseln("this message is filtered out");
+    }
+
+    void logFilteredLazy(const uint32_t count) {
+        EZ_LOG("Bench");
+        for (uint32_t i = 0; i < count; i++) EZ_VERBOSELN("filtered, not even built: " + String(i));
+    }
+
+    void logEmitted(const uint32_t count) {
+        EZ_LOG("Bench");
+        for (uint32_t i = 0; i < count; i++) Log::debugln("an emitted message of typical length");
+    }
+
+    void logEmittedPrintf(const uint32_t count) {
+        EZ_LOG("Bench");
+        for (uint32_t i = 0; i < count; i++) {
+            Log::debuglnf("value %u of %s: %.2f", static_cast<unsigned>(i), "bench", 1.5);
+        }
+    }
+
+    void emptyScope() {
+        EZ_LOG("Bench");
+    }
+
+    void scopeEnterExit(const uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) emptyScope();
+    }
+
+
+    /**
+     * customLoggingElements with three levels (module -> class -> method), filters share long prefixes:
+     *    "Module03"  ->  "Module03Class07"  ->  "Module03Class07::method2"
+     */
+    std::vector<const LogCallsite*> treeCallsites;
+
+    LoggingConfig treeConfig(const uint32_t modules) {
+        LoggingConfig config = baseConfig();
+        char name[48];
+        for (uint32_t m = 0; m < modules; m++) {
+            std::vector<LoggingElement> classes;
+            for (uint32_t c = 0; c < 8; c++) {
+                std::vector<LoggingElement> methods;
+                for (uint32_t f = 0; f < 4; f++) {
+                    snprintf(name, sizeof(name), "Module%02uClass%02u::method%u", unsigned(m), unsigned(c),
+                             unsigned(f));
+                    methods.emplace_back(name, Loglevel::INFO);
+                }
+                snprintf(name, sizeof(name), "Module%02uClass%02u", unsigned(m), unsigned(c));
+                classes.emplace_back(name, methods);
+            }
+            snprintf(name, sizeof(name), "Module%02u", unsigned(m));
+            config.customLoggingElements.emplace_back(name, classes);
+        }
+
+        // Callsites below the deepest filters (the last module is the last one in the trie, too):
+        treeCallsites.clear();
+        for (uint32_t f = 0; f < 8; f++) {
+            snprintf(name, sizeof(name), "Module%02uClass07", unsigned(modules - 1));
+            const String method = "method" + String(f % 4) + (f < 4 ? "" : "Other");
+            treeCallsites.push_back(LogCallsite::get(String(name), method));
+        }
+        return config;
+    }
+
+    void treeLog(const uint32_t count) {
+        AutoLog scope(treeCallsites[0]);
+        for (uint32_t i = 0; i < count; i++) Log::debugln("filtered by the tree");
+    }
+
+    LoggingConfig currentTreeConfig;
+
+    // updateConfig() compiles the filter and invalidates the cached decisions, the next call of each callsite
+    // searches the trie again:
+    void treeUpdate(const uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            Log::updateConfig(currentTreeConfig);
+            for (const LogCallsite* callsite : treeCallsites) {
+                AutoLog scope(callsite);
+                Log::debugln("filtered");
+            }
+        }
+    }
+
+
+    /**
+     * Emitted lines into a FileSink (in a temporary directory): the sector buffer, flushing and rotation
+     */
+    Result fileSink(const LogFormat format) {
+        char dir[] = "/tmp/ezlog-bench-XXXXXX";
+        if (mkdtemp(dir) == nullptr) return Result();
+
+        fs::FS filesystem(dir);
+        FileSink sink(filesystem, "/bench.log", 1024 * 1024, 2, Loglevel::VERBOSE, format);
+        LoggingConfig config = baseConfig();
+        config.sinks = {&sink};
+        Log::updateConfig(config);
+        benchFilesystem = &filesystem;
+        benchFileSink = &sink;
+
+        const Result result = measure(logEmitted);
+
+        Log::updateConfig(baseConfig());
+        benchFilesystem = nullptr;
+        benchFileSink = nullptr;
+        sink.close();
+        for (const char* file : {"/bench.log", "/bench.log.1"}) filesystem.remove(file);
+        rmdir(dir);
+        return result;
+    }
+
+
+    /**
+     * N tasks write emitted lines at the same time, so they compete for logSemaphoreMessage.
+     */
+    Result contention(const uint32_t threads) {
+        const uint64_t totalLines = quick ? (1u << 14) : (1u << 18);
+        const uint64_t linesPerThread = totalLines / threads;
+
+        std::vector<double> runs;
+        uint64_t allocs = 0;
+        unsigned long bytes = 0;
+        for (int rep = 0; rep < REPETITIONS; rep++) {
+            std::atomic<uint32_t> ready{0};
+            std::atomic<bool> go{false};
+            std::vector<std::thread> workers;
+            for (uint32_t t = 0; t < threads; t++) {
+                workers.emplace_back([&]() {
+                    logEmitted(16);
+                    ready.fetch_add(1);
+                    while (!go.load()) std::this_thread::yield();
+                    logEmitted(static_cast<uint32_t>(linesPerThread));
+                });
+            }
+            while (ready.load() < threads) std::this_thread::yield();
+
+            const uint64_t allocsBefore = HostHeap::allocations();
+            const unsigned long bytesBefore = Serial.bytesWritten;
+            const Clock::time_point start = Clock::now();
+            go.store(true);
+            for (std::thread& worker : workers) worker.join();
+            runs.push_back(elapsedNanos(start) / double(linesPerThread * threads));
+            allocs += HostHeap::allocations() - allocsBefore;
+            bytes += Serial.bytesWritten - bytesBefore;
+        }
+        std::sort(runs.begin(), runs.end());
+
+        Result result;
+        result.threads = threads;
+        result.calls = linesPerThread * threads;
+        result.nsPerCall = runs[REPETITIONS / 2];
+        result.nsMin = runs[0];
+        result.allocsPerCall = double(allocs) / (double(result.calls) * REPETITIONS);
+        result.bytesPerCall = double(bytes) / (double(result.calls) * REPETITIONS);
+        return result;
+    }
+
+
+    struct Case {
+        std::string name;
+        std::function<Result()> run;
+    };
+
+    std::vector<Case> cases() {
+        std::vector<Case> all;
+        const auto simple = [&all](const char* name, void (*body)(uint32_t), const LoggingConfig& config) {
+            all.push_back({name, [body, config]() {
+                Log::updateConfig(config);
+                return measure(body);
+            }});
+        };
+
+        simple("log_filtered", logFiltered, baseConfig());
+        simple("log_filtered_lazy", logFilteredLazy, baseConfig());
+        simple("log_emitted", logEmitted, baseConfig());
+        simple("log_emitted_printf", logEmittedPrintf, baseConfig());
+
+        LoggingConfig plain = baseConfig();
+        plain.outputFormat = LogFormat::PLAIN;
+        simple("log_emitted_plain", logEmitted, plain);
+
+        // Terse Output (doc/Configuration.MD): compare bytes_per_call with log_emitted
+        LoggingConfig terse = baseConfig();
+        terse.terseColors = true;
+        simple("log_emitted_terse", logEmitted, terse);
+
+        LoggingConfig terseDelta = terse;
+        terseDelta.timestampFormat = TimestampFormat::DELTA;
+        terseDelta.indentWidth = 1;
+        simple("log_emitted_terse_delta", logEmitted, terseDelta);
+
+        LoggingConfig binary = baseConfig();
+        binary.outputFormat = LogFormat::BINARY;
+        simple("log_emitted_binary", logEmitted, binary);
+
+        LoggingConfig silent = baseConfig();
+        silent.loglevel = Loglevel::ERROR;
+        simple("scope_filtered", scopeEnterExit, silent);
+        simple("scope_silent", scopeEnterExit, baseConfig());
+
+        LoggingConfig startEnd = baseConfig();
+        startEnd.printStartEndMessages = true;
+        simple("scope_logged", scopeEnterExit, startEnd);
+
+        LoggingConfig profiled = baseConfig();
+        profiled.profiling = true;
+        simple("scope_profiled", scopeEnterExit, profiled);
+
+        all.push_back({"filesink_plain", []() { return fileSink(LogFormat::PLAIN); }});
+        all.push_back({"filesink_binary", []() { return fileSink(LogFormat::BINARY); }});
+
+        for (const uint32_t modules : {1u, 8u, 64u}) {
+            const uint32_t elements = modules * (1 + 8 * (1 + 4));
+            all.push_back({"filter_tree_" + std::to_string(elements) + "_log", [modules]() {
+                Log::updateConfig(treeConfig(modules));
+                return measure(treeLog);
+            }});
+            all.push_back({"filter_tree_" + std::to_string(elements) + "_update", [modules]() {
+                currentTreeConfig = treeConfig(modules);
+                return measure(treeUpdate);
+            }});
+        }
+
+        for (const uint32_t threads : CONTENTION_THREADS) {
+            all.push_back({"contention_" + std::to_string(threads) + "t", [threads]() {
+                Log::updateConfig(baseConfig());
+                return contention(threads);
+            }});
+        }
+        return all;
+    }
+
+    bool selected(const std::string& name, const std::vector<std::string>& filters) {
+        if (filters.empty()) return true;
+        for (const std::string& filter : filters) {
+            if (name.find(filter) != std::string::npos) return true;
+        }
+        return false;
+    }
+}
+
+
+int main(int argc, char** argv) {
+    bool list = false;
+    std::vector<std::string> filters;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--quick") quick = true;
+        else if (arg == "--list") list = true;
+        else filters.push_back(arg);
+    }
+
+    Log::init(baseConfig());
+    Serial.setOutput(nullptr);      // the lines are only counted (bytes_per_call)
+
+    for (const Case& benchCase : cases()) {
+        if (!selected(benchCase.name, filters)) continue;
+        if (list) {
+            printf("%s\n", benchCase.name.c_str());
+            continue;
+        }
+        fprintf(stderr, "running %s ...\n", benchCase.name.c_str());
+        printResult(benchCase.name.c_str(), benchCase.run());
+    }
+    return 0;
+}
+
+#endif // PIO_UNIT_TESTING
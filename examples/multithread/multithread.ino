@@ -15,6 +15,9 @@ void setup() {
     LoggingConfig loggingConfig = {};
     loggingConfig.loglevel = Loglevel::VERBOSE;
 
+    /** Optional: records a timeline of all tasks, see Log::traceDump() */
+    // loggingConfig.tracing = true;
+
     /** Setup EZLog: */
     Log::init(loggingConfig);
 }
@@ -0,0 +1,221 @@
+#ifndef EZLOG_HOST_ARDUINO_H
+#define EZLOG_HOST_ARDUINO_H
+
+/**
+ * Minimal host stand-in for the parts of Arduino.h / arduino-esp32 which are used by EZLog.
+ * Only meant for native builds (benchmarks / tests), not a complete Arduino implementation.
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HEX 16
+#define DEC 10
+
+/** ***************************************
+ *                 String
+ *************************************** */
+class String {
+public:
+    String() = default;
+    String(const char* cstr) : s(cstr ? cstr : "") {}
+    String(const char* cstr, size_t len) : s(cstr, len) {}
+    String(const std::string& str) : s(str) {}
+    String(const String&) = default;
+    String(String&&) = default;
+    explicit String(char c) : s(1, c) {}
+    explicit String(unsigned char v, unsigned char base = 10) : s(toBase(v, base)) {}
+    explicit String(int v, unsigned char base = 10) : s(base == 10 ? std::to_string(v) : toBase((unsigned int)v, base)) {}
+    explicit String(unsigned int v, unsigned char base = 10) : s(toBase(v, base)) {}
+    explicit String(long v, unsigned char base = 10) : s(base == 10 ? std::to_string(v) : toBase((unsigned long)v, base)) {}
+    explicit String(unsigned long v, unsigned char base = 10) : s(toBase(v, base)) {}
+    explicit String(long long v) : s(std::to_string(v)) {}
+    explicit String(unsigned long long v) : s(std::to_string(v)) {}
+    explicit String(float v, unsigned int decimals = 2) : String((double)v, decimals) {}
+    explicit String(double v, unsigned int decimals = 2) {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.*f", (int)decimals, v);
+        s = buf;
+    }
+
+    String& operator=(const String&) = default;
+    String& operator=(String&&) = default;
+    String& operator=(const char* cstr) { s = cstr ? cstr : ""; return *this; }
+
+    String& operator+=(const String& rhs) { s += rhs.s; return *this; }
+    String& operator+=(const char* rhs) { s += rhs; return *this; }
+    String& operator+=(char c) { s += c; return *this; }
+
+    bool concat(const char* cstr, unsigned int len) { s.append(cstr, len); return true; }
+    bool reserve(unsigned int size) { s.reserve(size); return true; }
+
+    const char* c_str() const { return s.c_str(); }
+    unsigned int length() const { return (unsigned int)s.length(); }
+    bool isEmpty() const { return s.empty(); }
+
+    char charAt(unsigned int idx) const { return idx < s.length() ? s[idx] : 0; }
+    char operator[](unsigned int idx) const { return charAt(idx); }
+
+    bool equals(const String& rhs) const { return s == rhs.s; }
+    bool equals(const char* rhs) const { return s == rhs; }
+    bool operator==(const String& rhs) const { return s == rhs.s; }
+    bool operator==(const char* rhs) const { return s == rhs; }
+    bool operator!=(const String& rhs) const { return s != rhs.s; }
+    bool operator!=(const char* rhs) const { return s != rhs; }
+    bool operator<(const String& rhs) const { return s < rhs.s; }
+
+    bool startsWith(const String& prefix) const { return s.compare(0, prefix.s.length(), prefix.s) == 0; }
+    bool endsWith(const String& suffix) const {
+        return s.length() >= suffix.s.length() && s.compare(s.length() - suffix.s.length(), suffix.s.length(), suffix.s) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const { return pos(s.find(c, from)); }
+    int indexOf(const String& str, unsigned int from = 0) const { return pos(s.find(str.s, from)); }
+    int lastIndexOf(char c) const { return pos(s.rfind(c)); }
+    int lastIndexOf(const String& str) const { return pos(s.rfind(str.s)); }
+
+    String substring(unsigned int from) const { return from < s.length() ? String(s.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const {
+        if (from > to) std::swap(from, to);
+        if (from >= s.length()) return String();
+        return String(s.substr(from, to - from));
+    }
+
+    void trim() {
+        const size_t b = s.find_first_not_of(" \t\n\r\f\v");
+        const size_t e = s.find_last_not_of(" \t\n\r\f\v");
+        s = (b == std::string::npos) ? "" : s.substr(b, e - b + 1);
+    }
+
+    int toInt() const { return atoi(s.c_str()); }
+
+    const char* begin() const { return s.c_str(); }
+    const char* end() const { return s.c_str() + s.length(); }
+
+    friend String operator+(const String& lhs, const String& rhs) { String r(lhs); r.s += rhs.s; return r; }
+    friend String operator+(const String& lhs, const char* rhs) { String r(lhs); r.s += rhs; return r; }
+    friend String operator+(const char* lhs, const String& rhs) { String r(lhs); r.s += rhs.s; return r; }
+    friend String operator+(const String& lhs, char rhs) { String r(lhs); r.s += rhs; return r; }
+
+private:
+    static int pos(size_t p) { return p == std::string::npos ? -1 : (int)p; }
+
+    template <typename T>
+    static std::string toBase(T v, unsigned char base) {
+        if (base == 10) return std::to_string(v);
+        static const char* digits = "0123456789ABCDEF";
+        std::string out;
+        do {
+            out.insert(out.begin(), digits[v % base]);
+            v /= base;
+        } while (v != 0);
+        return out;
+    }
+
+    std::string s;
+};
+
+
+/** ***************************************
+ *              Print / Serial
+ *************************************** */
+class Print {
+public:
+    virtual ~Print() = default;
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buffer++);
+        return n;
+    }
+    size_t write(const char* str) { return str ? write((const uint8_t*)str, strlen(str)) : 0; }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+
+    size_t print(const String& s) { return write(s.c_str(), s.length()); }
+    size_t print(const char* s) { return write(s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return print(String(v)); }
+    size_t print(unsigned int v) { return print(String(v)); }
+    size_t print(long v) { return print(String(v)); }
+    size_t print(unsigned long v) { return print(String(v)); }
+    size_t print(double v, int decimals = 2) { return print(String(v, decimals)); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T& v) { size_t n = print(v); return n + println(); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+};
+
+/**
+ * Host-Serial: writes to stdout by default. Benchmarks can redirect or swallow the output.
+ */
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    void end() {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int availableForWrite() override { return txAvailable; }
+    void flush() override;
+    operator bool() const { return true; }
+
+    using Print::write;
+
+    /** Host only: redirect output (nullptr = discard) */
+    void setOutput(FILE* out) { output = out; }
+    /** Host only: capture output into a String */
+    void setCapture(String* capture) { captureTarget = capture; }
+    /** Host only: simulated free TX-Fifo space */
+    void setAvailableForWrite(int available) { txAvailable = available; }
+
+    std::atomic<unsigned long> bytesWritten{0};
+    std::atomic<unsigned long> writeCalls{0};
+
+private:
+    FILE* output = stdout;
+    String* captureTarget = nullptr;
+    int txAvailable = 1 << 20;
+};
+
+extern HardwareSerial Serial;
+
+
+/** ***************************************
+ *                 Timing
+ *************************************** */
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+
+#include "freertos/FreeRTOS.h"
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#endif // EZLOG_HOST_ARDUINO_H
@@ -0,0 +1,96 @@
+#ifndef EZLOG_HOST_FS_H
+#define EZLOG_HOST_FS_H
+
+/**
+ * Host stand-in for the Arduino FS-API (LittleFS/SPIFFS/SD): all paths are mapped into a directory.
+ * Counts the write() calls, so benchmarks can report the bytes per flash write.
+ */
+
+#include "Arduino.h"
+#include <memory>
+#include <string>
+
+#define FILE_READ       "r"
+#define FILE_WRITE      "w"
+#define FILE_APPEND     "a"
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File : public Stream {
+public:
+    File() = default;
+    explicit File(FILE* _fp, std::atomic<uint32_t>* _writes) : fp(_fp, fclose), writes(_writes) {}
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override {
+        if (!fp) return 0;
+        if (writes != nullptr) writes->fetch_add(1);
+        return fwrite(buffer, 1, size, fp.get());
+    }
+    using Print::write;
+
+    size_t read(uint8_t* buffer, size_t size) { return fp ? fread(buffer, 1, size, fp.get()) : 0; }
+    int read() override {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+    bool seek(uint32_t pos, SeekMode mode = SeekSet) {
+        return fp && fseek(fp.get(), pos, mode == SeekSet ? SEEK_SET : (mode == SeekCur ? SEEK_CUR : SEEK_END)) == 0;
+    }
+    size_t position() const { return fp ? ftell(fp.get()) : 0; }
+    size_t size() const {
+        if (!fp) return 0;
+        const long pos = ftell(fp.get());
+        fseek(fp.get(), 0, SEEK_END);
+        const long end = ftell(fp.get());
+        fseek(fp.get(), pos, SEEK_SET);
+        return end;
+    }
+    void flush() override {
+        if (fp) fflush(fp.get());
+    }
+    void close() { fp.reset(); }
+    operator bool() const { return fp != nullptr; }
+
+private:
+    std::shared_ptr<FILE> fp;
+    std::atomic<uint32_t>* writes = nullptr;
+};
+
+class FS {
+public:
+    explicit FS(const std::string& _root) : root(_root) {}
+
+    File open(const char* path, const char* mode = FILE_READ, bool = false) {
+        FILE* fp = fopen((root + path).c_str(), mode[0] == 'r' ? "rb" : (mode[0] == 'a' ? "ab+" : "wb+"));
+        return fp ? File(fp, &writeCalls) : File();
+    }
+    File open(const String& path, const char* mode = FILE_READ, bool = false) {
+        return open(path.c_str(), mode);
+    }
+    bool exists(const char* path) {
+        FILE* fp = fopen((root + path).c_str(), "rb");
+        if (fp) fclose(fp);
+        return fp != nullptr;
+    }
+    bool exists(const String& path) { return exists(path.c_str()); }
+    bool remove(const char* path) { return ::remove((root + path).c_str()) == 0; }
+    bool remove(const String& path) { return remove(path.c_str()); }
+    bool rename(const char* from, const char* to) { return ::rename((root + from).c_str(), (root + to).c_str()) == 0; }
+    bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+
+    std::atomic<uint32_t> writeCalls{0};
+
+private:
+    std::string root;
+};
+
+}  // namespace fs
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+
+#endif // EZLOG_HOST_FS_H
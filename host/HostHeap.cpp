@@ -0,0 +1,82 @@
+/**
+ * Replacement of the global operator new/delete: each block gets a header with its size, so the used bytes are known.
+ */
+#include "HostHeap.h"
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+    // Keeps the alignment of malloc() for the block behind the header
+    constexpr size_t HEADER_SIZE = alignof(std::max_align_t) > sizeof(size_t) ? alignof(std::max_align_t)
+                                                                               : sizeof(size_t);
+
+    std::atomic<uint64_t> allocationCount{0};
+    std::atomic<size_t> allocatedBytes{0};
+
+    void* allocate(const size_t size) noexcept {
+        auto* block = static_cast<unsigned char*>(malloc(size + HEADER_SIZE));
+        if (block == nullptr) return nullptr;
+        *reinterpret_cast<size_t*>(block) = size;
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        return block + HEADER_SIZE;
+    }
+
+    void release(void* ptr) noexcept {
+        if (ptr == nullptr) return;
+        unsigned char* block = static_cast<unsigned char*>(ptr) - HEADER_SIZE;
+        allocatedBytes.fetch_sub(*reinterpret_cast<size_t*>(block), std::memory_order_relaxed);
+        free(block);
+    }
+
+    void* allocateOrThrow(const size_t size) {
+        void* ptr = allocate(size);
+        if (ptr == nullptr) throw std::bad_alloc();
+        return ptr;
+    }
+}
+
+void* operator new(size_t size) { return allocateOrThrow(size); }
+void* operator new[](size_t size) { return allocateOrThrow(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void operator delete(void* ptr) noexcept { release(ptr); }
+void operator delete[](void* ptr) noexcept { release(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { release(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { release(ptr); }
+void operator delete(void* ptr, size_t) noexcept { release(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { release(ptr); }
+
+
+uint64_t HostHeap::allocations() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+size_t HostHeap::usedBytes() {
+    return allocatedBytes.load(std::memory_order_relaxed);
+}
+
+size_t HostHeap::freeBytes() {
+    const size_t used = usedBytes();
+    return used < HEAP_SIZE ? HEAP_SIZE - used : 0;
+}
+
+
+/** ***************************************
+ *            ESP-IDF Heap-API
+ *************************************** */
+size_t heap_caps_get_free_size(unsigned int caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? HostHeap::PSRAM_SIZE : HostHeap::freeBytes();
+}
+
+size_t heap_caps_get_largest_free_block(unsigned int caps) {
+    return heap_caps_get_free_size(caps);
+}
+
+uint32_t esp_get_free_heap_size() {
+    return static_cast<uint32_t>(heap_caps_get_free_size(MALLOC_CAP_8BIT));
+}
@@ -0,0 +1,30 @@
+#ifndef EZLOG_HOST_HEAP_H
+#define EZLOG_HOST_HEAP_H
+
+/**
+ * Counting allocator of the host build: operator new/delete are replaced (HostHeap.cpp), so benchmarks can report
+ * the allocations per log call, and heap_caps_get_free_size() returns a simulated heap, which really shrinks by the
+ * bytes, that are allocated with new (f.e. by String) - the heap tracker and the memory-info see real deltas.
+ *
+ * malloc() of the C library (fopen, vsnprintf, ...) is not counted.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+namespace HostHeap {
+    /** Size of the simulated internal heap / PSRAM in bytes */
+    constexpr size_t HEAP_SIZE = 320 * 1024;
+    constexpr size_t PSRAM_SIZE = 4 * 1024 * 1024;
+
+    /** Number of operator new calls since the start */
+    uint64_t allocations();
+
+    /** Bytes, which are currently allocated by operator new */
+    size_t usedBytes();
+
+    /** HEAP_SIZE - usedBytes() (0, if more is allocated) */
+    size_t freeBytes();
+}
+
+#endif // EZLOG_HOST_HEAP_H
@@ -0,0 +1,6 @@
+#ifndef EZLOG_HOST_ESP_DEBUG_HELPERS_H
+#define EZLOG_HOST_ESP_DEBUG_HELPERS_H
+
+int esp_backtrace_print(int depth);
+
+#endif // EZLOG_HOST_ESP_DEBUG_HELPERS_H
@@ -0,0 +1,14 @@
+#ifndef EZLOG_HOST_ESP_HEAP_CAPS_H
+#define EZLOG_HOST_ESP_HEAP_CAPS_H
+
+#include <cstddef>
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+size_t heap_caps_get_free_size(unsigned int caps);
+size_t heap_caps_get_largest_free_block(unsigned int caps);
+
+#endif // EZLOG_HOST_ESP_HEAP_CAPS_H
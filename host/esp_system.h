@@ -0,0 +1,15 @@
+#ifndef EZLOG_HOST_ESP_SYSTEM_H
+#define EZLOG_HOST_ESP_SYSTEM_H
+
+#include <cstdint>
+
+uint32_t esp_get_free_heap_size();
+
+typedef enum {
+    ESP_RST_UNKNOWN, ESP_RST_POWERON, ESP_RST_EXT, ESP_RST_SW, ESP_RST_PANIC, ESP_RST_INT_WDT, ESP_RST_TASK_WDT,
+    ESP_RST_WDT, ESP_RST_DEEPSLEEP, ESP_RST_BROWNOUT, ESP_RST_SDIO
+} esp_reset_reason_t;
+
+inline esp_reset_reason_t esp_reset_reason() { return ESP_RST_SW; }
+
+#endif // EZLOG_HOST_ESP_SYSTEM_H
@@ -0,0 +1,8 @@
+#ifndef EZLOG_HOST_ESP_TIMER_H
+#define EZLOG_HOST_ESP_TIMER_H
+
+#include <cstdint>
+
+int64_t esp_timer_get_time();
+
+#endif // EZLOG_HOST_ESP_TIMER_H
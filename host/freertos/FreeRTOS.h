@@ -0,0 +1,60 @@
+#ifndef EZLOG_HOST_FREERTOS_H
+#define EZLOG_HOST_FREERTOS_H
+
+/**
+ * Minimal host stand-in for the FreeRTOS task/semaphore API used by EZLog.
+ * Tasks are mapped to std::thread, mutexes to std::timed_mutex.
+ */
+
+#include <cstdint>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  pdTRUE
+#define pdFAIL                  pdFALSE
+#define portTICK_PERIOD_MS      1
+#define portMAX_DELAY           ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(ms))
+#define tskNO_AFFINITY          0x7FFFFFFF
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 1
+
+struct HostTask;
+struct HostSemaphore;
+typedef HostTask* TaskHandle_t;
+typedef HostSemaphore* SemaphoreHandle_t;
+
+/** Semaphores */
+SemaphoreHandle_t xSemaphoreCreateMutex();
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex();
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem);
+void vSemaphoreDelete(SemaphoreHandle_t sem);
+
+/** Tasks */
+TaskHandle_t xTaskGetCurrentTaskHandle();
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* param,
+                       UBaseType_t priority, TaskHandle_t* created);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* param,
+                                   UBaseType_t priority, TaskHandle_t* created, BaseType_t core);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount();
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+
+/** Task-Notifications */
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks);
+
+/** Thread-Local-Storage */
+typedef void (*TlsDeleteCallbackFunction_t)(int, void*);
+void* pvTaskGetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index);
+void vTaskSetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index, void* value);
+void vTaskSetThreadLocalStoragePointerAndDelCallback(TaskHandle_t task, BaseType_t index, void* value,
+                                                     TlsDeleteCallbackFunction_t callback);
+
+#endif // EZLOG_HOST_FREERTOS_H
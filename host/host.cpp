@@ -0,0 +1,212 @@
+/**
+ * Host implementation of the Arduino / FreeRTOS / ESP-IDF stand-ins (the heap is in HostHeap.cpp).
+ */
+#include "Arduino.h"
+#include "esp_debug_helpers.h"
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdarg>
+#include <future>
+
+HardwareSerial Serial;
+
+static const auto hostStartTime = std::chrono::steady_clock::now();
+
+/** ***************************************
+ *              Print / Serial
+ *************************************** */
+size_t Print::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    const int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (len <= 0) return 0;
+    return write(buffer, std::min((size_t)len, sizeof(buffer) - 1));
+}
+
+size_t HardwareSerial::write(const uint8_t* buffer, size_t size) {
+    bytesWritten += size;
+    writeCalls++;
+    if (captureTarget) captureTarget->concat((const char*)buffer, size);
+    if (output) fwrite(buffer, 1, size, output);
+    return size;
+}
+
+void HardwareSerial::flush() {
+    if (output) fflush(output);
+}
+
+/** ***************************************
+ *                 Timing
+ *************************************** */
+int64_t esp_timer_get_time() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - hostStartTime).count();
+}
+
+unsigned long millis() { return (unsigned long)(esp_timer_get_time() / 1000); }
+unsigned long micros() { return (unsigned long)esp_timer_get_time(); }
+void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void delayMicroseconds(unsigned int us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+void yield() { std::this_thread::yield(); }
+
+/** ***************************************
+ *                 System
+ *************************************** */
+int esp_backtrace_print(int) {
+    fprintf(stderr, "<backtrace not available on host>\n");
+    return 0;
+}
+
+/** ***************************************
+ *                Semaphores
+ *************************************** */
+struct HostSemaphore {
+    std::recursive_timed_mutex mutex;
+    bool recursive = false;
+    std::atomic<int> depth{0};
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex() { return new HostSemaphore(); }
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() {
+    HostSemaphore* sem = new HostSemaphore();
+    sem->recursive = true;
+    return sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks) {
+    bool locked = (ticks == portMAX_DELAY)
+        ? (sem->mutex.lock(), true)
+        : sem->mutex.try_lock_for(std::chrono::milliseconds(ticks * portTICK_PERIOD_MS));
+    if (!locked) return pdFALSE;
+    if (!sem->recursive && sem->depth > 0) {
+        // FreeRTOS-Mutexes are not recursive: emulate a failed take
+        sem->mutex.unlock();
+        if (ticks != portMAX_DELAY) std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+        return pdFALSE;
+    }
+    sem->depth++;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem) {
+    sem->depth--;
+    sem->mutex.unlock();
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem) { delete sem; }
+
+/** ***************************************
+ *                  Tasks
+ *************************************** */
+struct HostTask {
+    std::mutex notifyMutex;
+    std::condition_variable notifyCv;
+    uint32_t notifyValue = 0;
+    void* tls[configNUM_THREAD_LOCAL_STORAGE_POINTERS] = {};
+    TlsDeleteCallbackFunction_t tlsCallbacks[configNUM_THREAD_LOCAL_STORAGE_POINTERS] = {};
+
+    ~HostTask() {
+        for (int i = 0; i < configNUM_THREAD_LOCAL_STORAGE_POINTERS; i++) {
+            if (tlsCallbacks[i] && tls[i]) tlsCallbacks[i](i, tls[i]);
+        }
+    }
+};
+
+namespace {
+    struct TaskDeleted {};
+
+    struct TaskHolder {
+        HostTask* task = nullptr;
+        ~TaskHolder() { delete task; }
+    };
+
+    thread_local TaskHolder currentTask;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    if (!currentTask.task) currentTask.task = new HostTask();
+    return currentTask.task;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char*, uint32_t, void* param, UBaseType_t, TaskHandle_t* created) {
+    std::mutex m;
+    std::condition_variable cv;
+    TaskHandle_t handle = nullptr;
+
+    std::thread([&, fn, param]() {
+        TaskHandle_t self = xTaskGetCurrentTaskHandle();
+        {
+            std::lock_guard<std::mutex> guard(m);
+            handle = self;
+        }
+        cv.notify_one();
+        try {
+            fn(param);
+        } catch (const TaskDeleted&) {
+        }
+    }).detach();
+
+    std::unique_lock<std::mutex> lock(m);
+    cv.wait(lock, [&] { return handle != nullptr; });
+    if (created) *created = handle;
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackDepth, void* param,
+                                   UBaseType_t priority, TaskHandle_t* created, BaseType_t) {
+    return xTaskCreate(fn, name, stackDepth, param, priority, created);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == nullptr || task == currentTask.task) throw TaskDeleted();
+    // deleting other tasks is not supported on host builds
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks * portTICK_PERIOD_MS));
+}
+
+TickType_t xTaskGetTickCount() { return (TickType_t)millis(); }
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 4096; }
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    {
+        std::lock_guard<std::mutex> guard(task->notifyMutex);
+        task->notifyValue++;
+    }
+    task->notifyCv.notify_one();
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+    HostTask* task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(task->notifyMutex);
+    const auto pred = [task] { return task->notifyValue > 0; };
+    if (ticks == portMAX_DELAY) task->notifyCv.wait(lock, pred);
+    else task->notifyCv.wait_for(lock, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), pred);
+    const uint32_t value = task->notifyValue;
+    if (value > 0) task->notifyValue = clearOnExit ? 0 : value - 1;
+    return value;
+}
+
+void* pvTaskGetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index) {
+    if (!task) task = xTaskGetCurrentTaskHandle();
+    return task->tls[index];
+}
+
+void vTaskSetThreadLocalStoragePointer(TaskHandle_t task, BaseType_t index, void* value) {
+    vTaskSetThreadLocalStoragePointerAndDelCallback(task, index, value, nullptr);
+}
+
+void vTaskSetThreadLocalStoragePointerAndDelCallback(TaskHandle_t task, BaseType_t index, void* value,
+                                                     TlsDeleteCallbackFunction_t callback) {
+    if (!task) task = xTaskGetCurrentTaskHandle();
+    task->tls[index] = value;
+    task->tlsCallbacks[index] = callback;
+}
@@ -1,42 +1,188 @@
 #include "EZLog.h"
+#include <algorithm>
 #include <sstream>
 #include <esp_debug_helpers.h>
-#include <map>
 #include <mutex>
+#ifdef ESP_PLATFORM
+    #include <pthread.h>
+#endif
 
 /**
  * Sets LoggingConfig
  */
 void EZLog::init(const LoggingConfig& _loggingConfig) {
-    config = _loggingConfig;
+    LogTimestamp::calibrate();
+    updateConfig(_loggingConfig);
 }
 
 /**
- * Updates LoggingConfig
+ * Updates LoggingConfig. Can be called while other tasks are logging (see _applyConfig()), but not from a custom
+ * action (it waits for all log calls, which may still see the old config, to return).
  */
 void EZLog::updateConfig(const LoggingConfig& _loggingConfig) {
-    config = _loggingConfig;
+    static std::mutex updateMutex;
+    std::lock_guard<std::mutex> guard(updateMutex);
+
+    _allocateBuffers(_loggingConfig);
+    const size_t crashRecords = _loggingConfig.crashRing ? LogCrashRing::begin() : 0;
+    const LoggingConfig* previousConfig = _applyConfig(_loggingConfig);
+    const LogFilter* previousFilter = _compileFilter();
+    _waitForReaders();
+    if (previousConfig != &defaultConfig) delete previousConfig;
+    delete previousFilter;
+
+    if (crashRecords > 0) _dumpCrashRing();
+    if (_config().asyncMode || std::any_of(_config().sinks.begin(), _config().sinks.end(),
+                                        [](const LogSink* sink) { return sink->wantsPoll(); })) {
+        _startAsyncWriter();
+    }
+}
+
+/**
+ * Replaces the config as a whole: the copy is made before, the pointer is exchanged under logSemaphoreMessage and
+ * logSemaphoreAsync. So neither a task, which writes a line, nor the writer task (it needs both locks) ever sees
+ * the sinks half replaced. Lines, which are still buffered (async mode), are written to the old sinks before.
+ * Returns the old config, updateConfig() deletes it, when no task can read it anymore (see _waitForReaders()).
+ */
+const LoggingConfig* EZLog::_applyConfig(const LoggingConfig& newConfig) {
+    const LoggingConfig* next = new LoggingConfig(newConfig);
+    if (xSemaphoreTake(logSemaphoreMessage, portMAX_DELAY) != pdTRUE) return next;
+    if (xSemaphoreTake(logSemaphoreAsync, portMAX_DELAY) != pdTRUE) {
+        xSemaphoreGive(logSemaphoreMessage);
+        return next;
+    }
+
+    _writeAsyncBuffers();
+    if (_config().asyncMode && !next->asyncMode) {
+        for (LogSink* sink : _sinks()) sink->flush();
+    }
+
+    const LoggingConfig* previous = config.exchange(next);
+    defaultSink.format = _config().outputFormat;
+    _updateSinkFormats();
+    for (LogSink* sink : _sinks()) sink->resetCallsites();     // binary: the names are sent again
+
+    xSemaphoreGive(logSemaphoreAsync);
+    xSemaphoreGive(logSemaphoreMessage);
+    return previous;
+}
+
+/**
+ * Tables of profiler/tracing must exist, before another task can see the new config
+ */
+void EZLog::_allocateBuffers(const LoggingConfig& newConfig) {
+    if (newConfig.profiling) LogProfiler::enable();
+    if (newConfig.heapTracking) LogHeapTracker::enable();
+    if (newConfig.tracing) LogTrace::enable(newConfig.traceBufferEvents);
+}
+
+/**
+ * Prints the lines, which the crash ring kept from the previous boot, to all sinks
+ */
+void EZLog::_dumpCrashRing() {
+    if (xSemaphoreTake(logSemaphoreMessage, 1000 / portTICK_PERIOD_MS) != pdTRUE) return;
+    SinkPrint out;
+    LogCrashRing::dump(out, true);
+    xSemaphoreGive(logSemaphoreMessage);
 }
 
 /**
  * Gets an EZLog* Instance for the actual Task.
  * This is necessary, if there are more than one task (multiple Cores/ multiple Tasks) using EZLog.
+ *
+ * The instance is stored in a Thread-Local-Storage-Pointer of the task, so the lookup needs no lock.
+ * When the task is deleted, its instance (and taskID) is recycled for the next new task.
+ */
+#if defined(ESP_PLATFORM) && defined(EZLOG_TLS_INDEX)
+static_assert(EZLOG_TLS_INDEX > 0 && EZLOG_TLS_INDEX < configNUM_THREAD_LOCAL_STORAGE_POINTERS,
+              "EZLOG_TLS_INDEX: pointer 0 belongs to the pthread-keys, use 1 .. "
+              "CONFIG_FREERTOS_THREAD_LOCAL_STORAGE_POINTERS - 1");
+
+EZLog* EZLog::getInstanceForCurrentTask() {
+    auto* instance = static_cast<EZLog*>(pvTaskGetThreadLocalStoragePointer(nullptr, EZLOG_TLS_INDEX));
+    if (instance == nullptr) {
+        instance = _createInstance();
+        vTaskSetThreadLocalStoragePointerAndDelCallback(nullptr, EZLOG_TLS_INDEX, instance,
+                                                        [](int, void* deleted) {
+                                                            _retireInstance(static_cast<EZLog*>(deleted));
+                                                        });
+    }
+    return instance;
+}
+#elif defined(ESP_PLATFORM)
+/**
+ * Only one Thread-Local-Storage-Pointer (the one of the pthread-keys): the instance is stored in a pthread-key.
+ * ESP-IDF runs its destructor for every deleted task, also for tasks, which were not created by pthread.
  */
 EZLog* EZLog::getInstanceForCurrentTask() {
-    TaskHandle_t currentTask = xTaskGetCurrentTaskHandle();
+    static const pthread_key_t key = [] {
+        pthread_key_t created = 0;
+        pthread_key_create(&created, [](void* deleted) { _retireInstance(static_cast<EZLog*>(deleted)); });
+        return created;
+    }();
+
+    auto* instance = static_cast<EZLog*>(pthread_getspecific(key));
+    if (instance == nullptr) {
+        instance = _createInstance();
+        pthread_setspecific(key, instance);
+    }
+    return instance;
+}
+#else
+EZLog* EZLog::getInstanceForCurrentTask() {
+    // Host-Builds: thread_local, the destructor runs when the thread ends
+    struct InstanceHolder {
+        EZLog* instance = nullptr;
+        ~InstanceHolder() { if (instance != nullptr) _retireInstance(instance); }
+    };
+    thread_local InstanceHolder holder;
 
-    static std::map<TaskHandle_t, EZLog*> logInstances;
-    static std::mutex logMutex;
+    if (holder.instance == nullptr) holder.instance = _createInstance();
+    return holder.instance;
+}
+#endif
 
-    // locking the map, while accessing
-    std::lock_guard<std::mutex> guard(logMutex);
+/**
+ * Reuses the instance of a deleted task or creates a new one.
+ * Only called once per task, so the lock doesn't matter here.
+ */
+EZLog* EZLog::_createInstance() {
+    static std::mutex createMutex;
+    std::lock_guard<std::mutex> guard(createMutex);
+
+    // Only one task pops at the same time (mutex), pushes from _retireInstance() are lock-free:
+    EZLog* instance = retiredInstances.load(std::memory_order_acquire);
+    while (instance != nullptr &&
+           !retiredInstances.compare_exchange_weak(instance, instance->nextRetired, std::memory_order_acq_rel)) {
+    }
 
-    // create new EZLog-Instance, if not yet existing:
-    if (logInstances.find(currentTask) == logInstances.end()) {
+    if (instance == nullptr) {
         lastTaskID++;
-        logInstances[currentTask] = new EZLog(lastTaskID);
+        return new EZLog(lastTaskID);
+    }
+
+    // Reset the state of the old task. The ring buffer (async mode) stays registered and is simply continued.
+    instance->nextRetired = nullptr;
+    instance->depth = 0;
+    instance->newLineStarted = true;
+    instance->scopeDepth = 0;
+    instance->scopeOverflowDepth = 0;
+    instance->currentCallsite = nullptr;
+    instance->multilineBuffer.clear();
+    instance->lineBuffer.clear();
+    instance->formatBuffer.clear();
+    instance->lastloglevel = Loglevel::ERROR;
+    return instance;
+}
+
+/**
+ * Called, when a task is deleted (FreeRTOS TLS-Delete-Callback, may run in the idle task -> must not block).
+ */
+void EZLog::_retireInstance(EZLog* instance) {
+    instance->nextRetired = retiredInstances.load(std::memory_order_relaxed);
+    while (!retiredInstances.compare_exchange_weak(instance->nextRetired, instance, std::memory_order_release,
+                                                   std::memory_order_relaxed)) {
     }
-    return logInstances[currentTask];
 }
 
 
@@ -47,9 +193,13 @@ EZLog* EZLog::getInstanceForCurrentTask() {
  * !! DON'T CALL IT DIRECTLY !!
  */
 bool EZLog::start(const String& cls, const String& method) {
+    return start(LogCallsite::get(cls, method));
+}
+
+bool EZLog::start(const LogCallsite* callsite) {
 #ifndef EZLOG_DISABLE_COMPLETELY
     EZLog* instance = getInstanceForCurrentTask();
-    return instance->_start(cls, method);
+    return instance->_start(callsite);
 #endif
     return false;
 }
@@ -75,20 +225,41 @@ void EZLog::end() {
  *************************************** */
 void EZLog::error(const String& msg) {
 #ifndef EZLOG_DISABLE_COMPLETELY
-    getInstanceForCurrentTask()->_msg(Loglevel::ERROR, msg);
+    getInstanceForCurrentTask()->_error(msg.c_str(), msg.length());
+#endif
+}
+
+void EZLog::error(const char* msg) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+    getInstanceForCurrentTask()->_error(msg, strlen(msg));
 #endif
 }
 
 void EZLog::errorln(const String& msg) {
 #ifndef EZLOG_DISABLE_COMPLETELY
-    getInstanceForCurrentTask()->_errorln(msg);
+    getInstanceForCurrentTask()->_errorln(msg.c_str(), msg.length());
+#endif
+}
+
+void EZLog::errorln(const char* msg) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+    getInstanceForCurrentTask()->_errorln(msg, strlen(msg));
 #endif
 }
 
+
 void EZLog::warn(const String& msg) {
 #ifndef EZLOG_DISABLE_COMPLETELY
 #if EZLOG_MAX_LOG_LEVEL >= WARN
-    getInstanceForCurrentTask()->_warn(msg);
+    getInstanceForCurrentTask()->_warn(msg.c_str(), msg.length());
+#endif
+#endif
+}
+
+void EZLog::warn(const char* msg) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+#if EZLOG_MAX_LOG_LEVEL >= WARN
+    getInstanceForCurrentTask()->_warn(msg, strlen(msg));
 #endif
 #endif
 }
@@ -96,15 +267,32 @@ void EZLog::warn(const String& msg) {
 void EZLog::warnln(const String& msg) {
 #ifndef EZLOG_DISABLE_COMPLETELY
 #if EZLOG_MAX_LOG_LEVEL >= WARN
-    getInstanceForCurrentTask()->_warnln(msg);
+    getInstanceForCurrentTask()->_warnln(msg.c_str(), msg.length());
 #endif
 #endif
 }
 
+void EZLog::warnln(const char* msg) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+#if EZLOG_MAX_LOG_LEVEL >= WARN
+    getInstanceForCurrentTask()->_warnln(msg, strlen(msg));
+#endif
+#endif
+}
+
+
 void EZLog::info(const String& msg) {
 #ifndef EZLOG_DISABLE_COMPLETELY
 #if EZLOG_MAX_LOG_LEVEL >= 2
-    getInstanceForCurrentTask()->_info(msg);
+    getInstanceForCurrentTask()->_info(msg.c_str(), msg.length());
+#endif
+#endif
+}
+
+void EZLog::info(const char* msg) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+#if EZLOG_MAX_LOG_LEVEL >= 2
+    getInstanceForCurrentTask()->_info(msg, strlen(msg));
 #endif
 #endif
 }
@@ -112,15 +300,32 @@ void EZLog::info(const String& msg) {
 void EZLog::infoln(const String& msg) {
 #ifndef EZLOG_DISABLE_COMPLETELY
 #if EZLOG_MAX_LOG_LEVEL >= 2
-    getInstanceForCurrentTask()->_infoln(msg);
+    getInstanceForCurrentTask()->_infoln(msg.c_str(), msg.length());
+#endif
+#endif
+}
+
+void EZLog::infoln(const char* msg) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+#if EZLOG_MAX_LOG_LEVEL >= 2
+    getInstanceForCurrentTask()->_infoln(msg, strlen(msg));
 #endif
 #endif
 }
 
+
 void EZLog::debug(const String& msg) {
 #ifndef EZLOG_DISABLE_COMPLETELY
 #if EZLOG_MAX_LOG_LEVEL >= 3
-    getInstanceForCurrentTask()->_debug(msg);
+    getInstanceForCurrentTask()->_debug(msg.c_str(), msg.length());
+#endif
+#endif
+}
+
+void EZLog::debug(const char* msg) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+#if EZLOG_MAX_LOG_LEVEL >= 3
+    getInstanceForCurrentTask()->_debug(msg, strlen(msg));
 #endif
 #endif
 }
@@ -128,15 +333,32 @@ void EZLog::debug(const String& msg) {
 void EZLog::debugln(const String& msg) {
 #ifndef EZLOG_DISABLE_COMPLETELY
 #if EZLOG_MAX_LOG_LEVEL >= 3
-    getInstanceForCurrentTask()->_debugln(msg);
+    getInstanceForCurrentTask()->_debugln(msg.c_str(), msg.length());
+#endif
+#endif
+}
+
+void EZLog::debugln(const char* msg) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+#if EZLOG_MAX_LOG_LEVEL >= 3
+    getInstanceForCurrentTask()->_debugln(msg, strlen(msg));
 #endif
 #endif
 }
 
+
 void EZLog::verbose(const String& msg) {
 #ifndef EZLOG_DISABLE_COMPLETELY
 #if EZLOG_MAX_LOG_LEVEL >= 4
-    getInstanceForCurrentTask()->_verbose(msg);
+    getInstanceForCurrentTask()->_verbose(msg.c_str(), msg.length());
+#endif
+#endif
+}
+
+void EZLog::verbose(const char* msg) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+#if EZLOG_MAX_LOG_LEVEL >= 4
+    getInstanceForCurrentTask()->_verbose(msg, strlen(msg));
 #endif
 #endif
 }
@@ -144,7 +366,125 @@ void EZLog::verbose(const String& msg) {
 void EZLog::verboseln(const String& msg) {
 #ifndef EZLOG_DISABLE_COMPLETELY
 #if EZLOG_MAX_LOG_LEVEL >= 4
-    getInstanceForCurrentTask()->_verboseln(msg);
+    getInstanceForCurrentTask()->_verboseln(msg.c_str(), msg.length());
+#endif
+#endif
+}
+
+void EZLog::verboseln(const char* msg) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+#if EZLOG_MAX_LOG_LEVEL >= 4
+    getInstanceForCurrentTask()->_verboseln(msg, strlen(msg));
+#endif
+#endif
+}
+
+
+/**
+ * printf-Style: the text is only formatted, if it will be printed (see isEnabled())
+ */
+void EZLog::errorf(const char* format, ...) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+    va_list args;
+    va_start(args, format);
+    _logf(Loglevel::ERROR, false, format, args);
+    va_end(args);
+#endif
+}
+
+void EZLog::errorlnf(const char* format, ...) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+    va_list args;
+    va_start(args, format);
+    _logf(Loglevel::ERROR, true, format, args);
+    va_end(args);
+#endif
+}
+
+void EZLog::warnf(const char* format, ...) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+#if EZLOG_MAX_LOG_LEVEL >= 1
+    va_list args;
+    va_start(args, format);
+    _logf(Loglevel::WARN, false, format, args);
+    va_end(args);
+#endif
+#endif
+}
+
+void EZLog::warnlnf(const char* format, ...) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+#if EZLOG_MAX_LOG_LEVEL >= 1
+    va_list args;
+    va_start(args, format);
+    _logf(Loglevel::WARN, true, format, args);
+    va_end(args);
+#endif
+#endif
+}
+
+void EZLog::infof(const char* format, ...) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+#if EZLOG_MAX_LOG_LEVEL >= 2
+    va_list args;
+    va_start(args, format);
+    _logf(Loglevel::INFO, false, format, args);
+    va_end(args);
+#endif
+#endif
+}
+
+void EZLog::infolnf(const char* format, ...) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+#if EZLOG_MAX_LOG_LEVEL >= 2
+    va_list args;
+    va_start(args, format);
+    _logf(Loglevel::INFO, true, format, args);
+    va_end(args);
+#endif
+#endif
+}
+
+void EZLog::debugf(const char* format, ...) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+#if EZLOG_MAX_LOG_LEVEL >= 3
+    va_list args;
+    va_start(args, format);
+    _logf(Loglevel::DEBUG, false, format, args);
+    va_end(args);
+#endif
+#endif
+}
+
+void EZLog::debuglnf(const char* format, ...) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+#if EZLOG_MAX_LOG_LEVEL >= 3
+    va_list args;
+    va_start(args, format);
+    _logf(Loglevel::DEBUG, true, format, args);
+    va_end(args);
+#endif
+#endif
+}
+
+void EZLog::verbosef(const char* format, ...) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+#if EZLOG_MAX_LOG_LEVEL >= 4
+    va_list args;
+    va_start(args, format);
+    _logf(Loglevel::VERBOSE, false, format, args);
+    va_end(args);
+#endif
+#endif
+}
+
+void EZLog::verboselnf(const char* format, ...) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+#if EZLOG_MAX_LOG_LEVEL >= 4
+    va_list args;
+    va_start(args, format);
+    _logf(Loglevel::VERBOSE, true, format, args);
+    va_end(args);
 #endif
 #endif
 }
@@ -158,6 +498,169 @@ void EZLog::freeMem(const String& prefix, bool inBytes) {
     getInstanceForCurrentTask()->_freeMem(prefix, inBytes);
 }
 
+void EZLog::hexdump(const Loglevel loglevel, const void* data, const size_t len) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+    if (static_cast<int>(loglevel) > EZLOG_MAX_LOG_LEVEL || data == nullptr || !isEnabled(loglevel)) return;
+    getInstanceForCurrentTask()->_hexdump(loglevel, static_cast<const uint8_t*>(data), len);
+#endif
+}
+
+bool EZLog::isEnabled(const Loglevel loglevel) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+    // Same rules as _msg(): ERROR always counts (restartESPonError), custom actions get every message,
+    // WARN is printed, if any sink accepts it. The crash ring records every line, which passes the filter.
+    if (loglevel == Loglevel::ERROR) return true;
+    ReadSection section;
+    if (loglevel == Loglevel::WARN && _config().customWarningAction) return true;
+    if (loglevel == Loglevel::INFO && _config().customInfoAction) return true;
+    if (loglevel == Loglevel::DEBUG && _config().customDebugAction) return true;
+    if (loglevel == Loglevel::VERBOSE && _config().customVerboseAction) return true;
+    if (_sinkFormats(loglevel) == 0 && !_config().crashRing) return false;
+    EZLog* instance = getInstanceForCurrentTask();
+    if (loglevel != Loglevel::WARN && (!_config().enabled || !instance->_shouldLog(loglevel))) return false;
+
+    // Empty token bucket: the message is not even built (counted as dropped like in _msg())
+    const LogCallsite* callsite = instance->currentCallsite;
+    const uint16_t rateLimit = callsite != nullptr ? _rateLimit(callsite) : 0;
+    if (rateLimit > 0 && !LogRateLimit::available(callsite, rateLimit, _config().rateLimitBurst, millis())) {
+        callsite->rateDropped.fetch_add(1, std::memory_order_relaxed);
+        rateLimitedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+#endif
+    return false;
+}
+
+
+/**
+ * Writes all lines, which are still buffered (async mode), to the sinks and flushes them.
+ * Should be called before a restart/abort, otherwise the buffered lines are lost.
+ */
+void EZLog::flush() {
+#ifndef EZLOG_DISABLE_COMPLETELY
+    // Pending "last message repeated N times":
+    ReadSection section;
+    if (_config().suppressRepeats) {
+        EZLog* instance = getInstanceForCurrentTask();
+        for (const LogCallsite* callsite = LogCallsite::first(); callsite != nullptr; callsite = callsite->next) {
+            instance->_flushRepeats(callsite);
+        }
+    }
+
+    _drainAsyncBuffers();
+    if (xSemaphoreTake(logSemaphoreMessage, 1000 / portTICK_PERIOD_MS) != pdTRUE) return;
+    for (LogSink* sink : _sinks()) sink->flush();
+    xSemaphoreGive(logSemaphoreMessage);
+#endif
+}
+
+/**
+ * Number of lines, which have been dropped because of a full ring buffer (async mode)
+ */
+uint32_t EZLog::asyncDroppedLines() {
+    uint32_t dropped = 0;
+    if (xSemaphoreTake(logSemaphoreAsync, 1000 / portTICK_PERIOD_MS) != pdTRUE) return 0;
+    for (const EZLog* instance : asyncInstances) {
+        dropped += instance->ringBuffer->dropped();
+    }
+    xSemaphoreGive(logSemaphoreAsync);
+    return dropped;
+}
+
+/**
+ * Number of lines with this loglevel, which didn't reach all sinks: the output lock wasn't available for a second,
+ * or a sink wasn't writable (LoggingConfig::backpressurePolicy)
+ */
+uint32_t EZLog::droppedLines(const Loglevel loglevel) {
+    return droppedCount[(int)loglevel].load(std::memory_order_relaxed);
+}
+
+/**
+ * Number of scopes, which were not tracked, because they were nested deeper than EZLOG_MAX_SCOPE_DEPTH
+ */
+uint32_t EZLog::scopeOverflows() {
+    return scopeOverflowCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * Number of lines, which have been dropped by the rate limit of their callsite
+ */
+uint32_t EZLog::rateLimitedLines() {
+    return rateLimitedCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * Number of lines, which have been collapsed into "last message repeated N times"
+ */
+uint32_t EZLog::repeatedLines() {
+    return repeatedCount.load(std::memory_order_relaxed);
+}
+
+/**
+ * Prints the statistics of the profiler (sorted by total time) to Serial
+ */
+void EZLog::profileReport(const bool histogram) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+    ReadSection section;
+    if (_config().asyncMode) flush();
+    if (xSemaphoreTake(logSemaphoreMessage, 1000 / portTICK_PERIOD_MS) != pdTRUE) return;
+    LogProfiler::report(Serial, histogram);
+    xSemaphoreGive(logSemaphoreMessage);
+#endif
+}
+
+void EZLog::profileReset() {
+    LogProfiler::reset();
+}
+
+/**
+ * Prints the heap deltas per callsite (sorted by net allocation), possible leaks are marked with "LEAK?"
+ */
+void EZLog::heapReport(Print& out) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+    ReadSection section;
+    if (_config().asyncMode) flush();
+    if (xSemaphoreTake(logSemaphoreMessage, 1000 / portTICK_PERIOD_MS) != pdTRUE) return;
+    LogHeapTracker::report(out);
+    xSemaphoreGive(logSemaphoreMessage);
+#endif
+}
+
+void EZLog::heapReset() {
+    LogHeapTracker::reset();
+}
+
+/**
+ * Writes the recorded scopes as Chrome Trace Event JSON (f.e. to Serial or a File)
+ */
+void EZLog::traceDump(Print& out) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+    ReadSection section;
+    if (_config().asyncMode) flush();
+    if (xSemaphoreTake(logSemaphoreMessage, 1000 / portTICK_PERIOD_MS) != pdTRUE) return;
+    LogTrace::dump(out);
+    xSemaphoreGive(logSemaphoreMessage);
+#endif
+}
+
+void EZLog::traceClear() {
+    LogTrace::clear();
+}
+
+/**
+ * Writes the lines in the crash ring (of this and the previous boot) as text
+ */
+void EZLog::crashDump(Print& out) {
+#ifndef EZLOG_DISABLE_COMPLETELY
+    ReadSection section;
+    if (_config().asyncMode) flush();
+    if (xSemaphoreTake(logSemaphoreMessage, 1000 / portTICK_PERIOD_MS) != pdTRUE) return;
+    LogCrashRing::dump(out, false);
+    xSemaphoreGive(logSemaphoreMessage);
+#endif
+}
+
 
 /** ***************************************
  *
@@ -166,73 +669,88 @@ void EZLog::freeMem(const String& prefix, bool inBytes) {
  *************************************** */
 
 
-bool EZLog::_start(const String& cls, const String& method) {
-    if (!config.enabled) return false;
+bool EZLog::_start(const LogCallsite* callsite) {
+    ReadSection section;
+    if (!_config().enabled) return false;
 
-    if (xSemaphoreTake(logSemaphoreStartStop, 1000 / portTICK_PERIOD_MS) != pdTRUE) {
-        Serial.println("Log-Semaphore not available!");
-        esp_backtrace_print(30);
-        return false;
+    if (scopeDepth >= EZLOG_MAX_SCOPE_DEPTH) {
+        scopeOverflowDepth++;
+        scopeOverflowCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
     }
 
-    classStack.push(cls);
-    methodStack.push(method);
-    startTimeStack.push(millis());
-    String prefix = cls + "::" + method;
+    // Disabled scope: only remembered for the messages inside, no output
+    const bool logged = _shouldLog(callsite, Loglevel::DEBUG);
 
-    if (!_shouldLog(prefix, Loglevel::DEBUG)) {
-        lastPrefix = prefix;
-        xSemaphoreGive(logSemaphoreStartStop);
-        return true;
-    }
+    // The time spent in here is not part of the duration - neither of this scope nor of the enclosing one:
+    const bool timed = logged || _config().profiling || (scopeDepth > 0 && scopeStack[scopeDepth - 1].timed);
+    const int64_t entryMicros = timed ? LogTimestamp::nowMicros() : 0;
 
-    newLineStarted = true;
-    lastPrefix = prefix;
-    if (config.printStartEndMessages) _msg(Loglevel::DEBUG, "\n", true);
-    depth++;
+    // The START-line is committed as a whole by _msg() (no lock around the scope)
+    if (logged) {
+        _pushScope(callsite, true, timed);
+        newLineStarted = true;
+        if (_config().printStartEndMessages) _msg(Loglevel::DEBUG, "", 0, true, true);
+        depth++;
+    } else {
+        _pushScope(callsite, false, timed);
+    }
 
-    xSemaphoreGive(logSemaphoreStartStop);
+    if (timed) {
+        ScopeFrame& frame = scopeStack[scopeDepth - 1];
+        frame.startMicros = LogTimestamp::nowMicros();
+        if (scopeDepth > 1) scopeStack[scopeDepth - 2].overheadMicros += frame.startMicros - entryMicros;
+    }
     return true;
 }
 
 void EZLog::_end() {
-    if (!config.enabled) return;
+    ReadSection section;
+    if (!_config().enabled) return;
 
-    if (xSemaphoreTake(logSemaphoreStartStop, 1000 / portTICK_PERIOD_MS) != pdTRUE) {
-        Serial.println("Log-Semaphore not available!");
-        esp_backtrace_print(30);
-        while (true) {
-            delay(1);
-        }
+    if (scopeOverflowDepth > 0) {
+        scopeOverflowDepth--;
+        return;
     }
 
-    if (classStack.empty() || methodStack.empty()) {
+    if (scopeDepth == 0) {
         // should not happen....
-        Serial.println("ERROR - Log::_end() without Log::_start() !!");
-        if (Serial) Serial.flush();
+        _writeError("ERROR - Log::_end() without Log::_start() !!");
         esp_backtrace_print(30);
         delay(1000);
-
-        xSemaphoreGive(logSemaphoreStartStop);
         return;
     }
-    String cls = classStack.top();
-    String method = methodStack.top();
-    unsigned long startTime = startTimeStack.top();
-    String prefix = cls + "::" + method;
-    classStack.pop();
-    methodStack.pop();
-    startTimeStack.pop();
-
-    if (prefix.length() == 0 || !_shouldLog(prefix, Loglevel::DEBUG)) {
-        if (!classStack.empty() && !methodStack.empty()) {
-            cls = classStack.top();
-            method = methodStack.top();
-            lastPrefix = cls + "::" + method;
-        }
-        xSemaphoreGive(logSemaphoreStartStop);
-        return;
+    const ScopeFrame frame = scopeStack[--scopeDepth];
+    const int64_t endMicros = frame.timed ? LogTimestamp::nowMicros() : 0;
+    const uint32_t duration = frame.timed ? _scopeDuration(frame, endMicros) : 0;
+
+    if (frame.heapTracked) _recordHeap(frame);
+    if (_config().addMemInfo && _config().memInfoSampling == MemInfoSampling::SCOPE_END) LogMemInfo::invalidate();
+    if (frame.profiled) LogProfiler::record(frame.callsite, duration);
+    if (_config().tracing) LogTrace::record(frame.callsite, static_cast<uint8_t>(taskID), LogTrace::END);
+
+    if (frame.logged) {
+        // the duration is printed by _msg():
+        lastDuration = duration;
+        lastSelfTime = duration > frame.childMicros ? duration - frame.childMicros : 0;
+        _endLogged(frame);
+    } else if (scopeDepth > 0) {
+        currentCallsite = scopeStack[scopeDepth - 1].callsite;
     }
+
+    // The enclosing scope gets this one as child - and the time spent in _start()/_end() as overhead:
+    if (frame.timed && scopeDepth > 0) {
+        ScopeFrame& parent = scopeStack[scopeDepth - 1];
+        parent.childMicros += duration;
+        parent.overheadMicros += frame.overheadMicros + static_cast<uint32_t>(LogTimestamp::nowMicros() - endMicros);
+        parent.nestedScopes += frame.nestedScopes + 1;
+    }
+}
+
+/**
+ * Writes the END-line of a scope, which wrote a START-line
+ */
+void EZLog::_endLogged(const ScopeFrame& frame) {
     depth--;
     if (depth < 0) {
         warnln("ERROR - depth < 0:  " + String(depth));
@@ -242,96 +760,222 @@ void EZLog::_end() {
         newLineStarted = true;
     }
 
-    String durationMsg = ANSICOLOR_RESET + " " + ANSICOLOR_BRIGHT_BLACK + " (" + String(millis() - startTime) + "ms)" +
-        ANSICOLOR_RESET;
+    currentCallsite = frame.callsite;
+    if (_config().printStartEndMessages) _msg(Loglevel::DEBUG, "", 0, true, false, true);
+    currentCallsite = scopeDepth > 0 ? scopeStack[scopeDepth - 1].callsite : nullptr;
+}
 
-    lastPrefix = prefix;
-    if (config.printStartEndMessages) _msg(Loglevel::DEBUG, durationMsg + "\n", false, true);
-    lastPrefix = "";
+/**
+ * Duration of the scope in µs without the cost of the logger: the time spent in _start()/_end() of nested scopes is
+ * measured, the timer reads, which can't measure themselves, are subtracted with the calibrated cost
+ * (LogTimestamp::calibrate(): one for this scope, two for each nested one).
+ */
+uint32_t EZLog::_scopeDuration(const ScopeFrame& frame, const int64_t endMicros) {
+    const int64_t calibrated = (static_cast<int64_t>(frame.nestedScopes) * 2 + 1) * LogTimestamp::readNanos() / 1000;
+    const int64_t duration = endMicros - frame.startMicros - frame.overheadMicros - calibrated;
+    return duration > 0 ? static_cast<uint32_t>(std::min<int64_t>(duration, UINT32_MAX)) : 0;
+}
 
-    if (!classStack.empty() && !methodStack.empty()) {
-        cls = classStack.top();
-        method = methodStack.top();
-        lastPrefix = cls + "::" + method;
-    } else {
-        lastPrefix = "";
+void EZLog::_pushScope(const LogCallsite* callsite, const bool logged, const bool timed) {
+    ScopeFrame& frame = scopeStack[scopeDepth++];
+    frame.callsite = callsite;
+    frame.startMicros = 0;
+    frame.childMicros = 0;
+    frame.overheadMicros = 0;
+    frame.nestedScopes = 0;
+    frame.timed = timed;
+    frame.heapTracked = _config().heapTracking;
+    frame.heapFree = frame.heapTracked ? LogHeapTracker::heapFree() : 0;
+    frame.psramFree = frame.heapTracked ? LogHeapTracker::psramFree() : 0;
+    frame.logged = logged;
+    frame.profiled = _config().profiling;
+
+    if (_config().tracing) LogTrace::record(callsite, static_cast<uint8_t>(taskID), LogTrace::BEGIN);
+    currentCallsite = callsite;
+}
+
+/**
+ * Heap tracking: memory, which the scope kept. Warns once per callsite, if it looks like a leak.
+ */
+void EZLog::_recordHeap(const ScopeFrame& frame) {
+    const auto heapUsed = static_cast<int32_t>(frame.heapFree - LogHeapTracker::heapFree());
+    const auto psramUsed = static_cast<int32_t>(frame.psramFree - LogHeapTracker::psramFree());
+    if (!LogHeapTracker::record(frame.callsite, heapUsed, psramUsed, _config().heapLeakThreshold)) return;
+
+    char notice[96];
+    snprintf(notice, sizeof(notice), "possible heap leak: %u calls in a row kept memory (last one %d bytes)",
+             static_cast<unsigned>(_config().heapLeakThreshold), static_cast<int>(heapUsed));
+    _writeNotice(frame.callsite, Loglevel::WARN, notice);
+}
+
+/**
+ * One line per 16 bytes, each one formatted with a lookup table (no printf/String). Offsets have 4 hex digits,
+ * 8 for more than 64 kB.
+ */
+void EZLog::_hexdump(const Loglevel loglevel, const uint8_t* data, const size_t len) {
+    ReadSection section;
+    static const char hexDigits[] = "0123456789abcdef";
+    constexpr size_t bytesPerLine = 16;
+    const uint8_t offsetDigits = len > 0x10000 ? 8 : 4;
+
+    char line[8 + 2 + bytesPerLine * 3 + 1 + 2 + bytesPerLine + 1];
+    for (size_t offset = 0; offset < len; offset += bytesPerLine) {
+        const size_t count = std::min(bytesPerLine, len - offset);
+        size_t pos = 0;
+        for (uint8_t shift = offsetDigits * 4; shift > 0; shift -= 4) {
+            line[pos++] = hexDigits[(offset >> (shift - 4)) & 0x0F];
+        }
+        line[pos++] = ' ';
+
+        for (size_t i = 0; i < bytesPerLine; i++) {
+            if (i == bytesPerLine / 2) line[pos++] = ' ';
+            line[pos++] = ' ';
+            if (i < count) {
+                line[pos++] = hexDigits[data[offset + i] >> 4];
+                line[pos++] = hexDigits[data[offset + i] & 0x0F];
+            } else {
+                line[pos++] = ' ';
+                line[pos++] = ' ';
+            }
+        }
+
+        line[pos++] = ' ';
+        line[pos++] = ' ';
+        line[pos++] = '|';
+        for (size_t i = 0; i < count; i++) {
+            const uint8_t c = data[offset + i];
+            line[pos++] = c >= 0x20 && c < 0x7F ? static_cast<char>(c) : '.';
+        }
+        line[pos++] = '|';
+
+        _msg(loglevel, line, pos, true);
+    }
+}
+
+void EZLog::_error(const char* msg, const size_t len) {
+    ReadSection section;
+    _msg(Loglevel::ERROR, msg, len);
+}
+
+void EZLog::_errorln(const char* msg, const size_t len) {
+    ReadSection section;
+    if (_config().customErrorAction) _config().customErrorAction(taskID, msg);
+    _msg(Loglevel::ERROR, msg, len, true);
+    if (_config().restartESPonError) {
+        flush();
+        abort();
     }
-    xSemaphoreGive(logSemaphoreStartStop);
 }
 
-void EZLog::_errorln(const String& msg) {
-    config.customErrorAction(taskID, msg);
-    error(msg + "\n");
-    if (config.restartESPonError) abort();
+void EZLog::_warn(const char* msg, const size_t len) {
+    ReadSection section;
+    _msg(Loglevel::WARN, msg, len);
 }
 
-void EZLog::_warn(const String& msg) {
-    _msg(Loglevel::WARN, msg);
+void EZLog::_warnln(const char* msg, const size_t len) {
+    ReadSection section;
+    if (_config().customWarningAction) _config().customWarningAction(taskID, msg);
+    _msg(Loglevel::WARN, msg, len, true);
 }
 
-void EZLog::_warnln(const String& msg) {
-    config.customWarningAction(taskID, msg);
-    _msg(Loglevel::WARN, msg + "\n");
+void EZLog::_info(const char* msg, const size_t len) {
+    ReadSection section;
+    _msg(Loglevel::INFO, msg, len);
 }
 
-void EZLog::_info(const String& msg) {
-    _msg(Loglevel::INFO, msg);
+void EZLog::_infoln(const char* msg, const size_t len) {
+    ReadSection section;
+    if (_config().customInfoAction) _config().customInfoAction(taskID, msg);
+    _msg(Loglevel::INFO, msg, len, true);
 }
 
-void EZLog::_infoln(const String& msg) {
-    config.customInfoAction(taskID, msg);
-    _msg(Loglevel::INFO, msg + "\n");
+void EZLog::_debug(const char* msg, const size_t len) {
+    ReadSection section;
+    _msg(Loglevel::DEBUG, msg, len);
 }
 
-void EZLog::_debug(const String& msg) {
-    _msg(Loglevel::DEBUG, msg);
+void EZLog::_debugln(const char* msg, const size_t len) {
+    ReadSection section;
+    if (_config().customDebugAction) _config().customDebugAction(taskID, msg);
+    _msg(Loglevel::DEBUG, msg, len, true);
 }
 
-void EZLog::_debugln(const String& msg) {
-    config.customDebugAction(taskID, msg);
-    _msg(Loglevel::DEBUG, msg + "\n");
+void EZLog::_verbose(const char* msg, const size_t len) {
+    ReadSection section;
+    _msg(Loglevel::VERBOSE, msg, len);
 }
 
-void EZLog::_verbose(const String& msg) {
-    _msg(Loglevel::VERBOSE, msg);
+void EZLog::_verboseln(const char* msg, const size_t len) {
+    ReadSection section;
+    if (_config().customVerboseAction) _config().customVerboseAction(taskID, msg);
+    _msg(Loglevel::VERBOSE, msg, len, true);
 }
 
-void EZLog::_verboseln(const String& msg) {
-    config.customVerboseAction(taskID, msg);
-    _msg(Loglevel::VERBOSE, msg + "\n");
+/**
+ * Formats directly into the formatBuffer of the task (no String, no heap, no copy on the stack) and passes the text
+ * on like error()/errorln() etc. A call from a custom action formats behind the text of the outer one.
+ */
+void EZLog::_logf(const Loglevel loglevel, const bool newline, const char* format, va_list args) {
+    if (!isEnabled(loglevel)) return;
+
+    EZLog* instance = getInstanceForCurrentTask();
+    LogLineBuffer& buffer = instance->formatBuffer;
+    const size_t start = buffer.length();
+    const size_t len = buffer.available() > 0 ? LogPrintf::format(buffer.tail(), buffer.available(), format, args) : 0;
+    const char* text = len > 0 ? buffer.tail() : "";
+    buffer.grow(len + 1);     // with the '\0' (custom actions)
+
+    switch (loglevel) {
+        case Loglevel::ERROR:
+            newline ? instance->_errorln(text, len) : instance->_error(text, len);
+            break;
+        case Loglevel::WARN:
+            newline ? instance->_warnln(text, len) : instance->_warn(text, len);
+            break;
+        case Loglevel::INFO:
+            newline ? instance->_infoln(text, len) : instance->_info(text, len);
+            break;
+        case Loglevel::DEBUG:
+            newline ? instance->_debugln(text, len) : instance->_debug(text, len);
+            break;
+        case Loglevel::VERBOSE:
+            newline ? instance->_verboseln(text, len) : instance->_verbose(text, len);
+            break;
+    }
+    buffer.shrink(start);
 }
 
-String EZLog::_colorPrefix(String prefix, boolean isStart, boolean isEnd) {
-    if (prefix == "") return prefix;
+/**
+ * Writes " ++ Class::method - [START]" (or the END-Version) of the current callsite
+ */
+void EZLog::_writeColorPrefix(const boolean isStart, const boolean isEnd) {
+    if (currentCallsite == nullptr) return;
 
-    String startStopPrefix;
-    String startStopSuffix;
+    const char* startStopPrefix = "";
+    const char* startStopSuffix = "";
     if (isStart) {
         startStopPrefix = " ++ ";
-        // startStopPrefix = "[START] ";
         startStopSuffix = " - [START]";
     } else if (isEnd) {
         startStopPrefix = " -- ";
-        // startStopPrefix = "[END] ";
         startStopSuffix = " - [END]";
     }
 
-    const auto result = split(prefix.c_str(), "::");
-    if (result.empty() || result.size() < 2) {
-        _errorln("ERROR!! Result empty: " + String(prefix.c_str()));
-    }
-    const String& cls = result[0];
-    const String& method = result[1];
-
-    String retVal = ANSICOLOR_YELLOW + startStopPrefix + ansiColorReset()
-        + ANSICOLOR_GREEN + cls + ansiColorReset() + "::" + ANSICOLOR_BLUE + method
-        + ANSICOLOR_YELLOW + startStopSuffix
-        + ansiColorReset();
-
-    return retVal;
+    lineBuffer.append(ANSICOLOR_YELLOW);
+    lineBuffer.append(startStopPrefix);
+    _writeColorReset();
+    lineBuffer.append(ANSICOLOR_GREEN);
+    lineBuffer.append(currentCallsite->cls, currentCallsite->clsLen);
+    _writeColorReset();
+    lineBuffer.append("::");
+    lineBuffer.append(ANSICOLOR_BLUE);
+    lineBuffer.append(currentCallsite->method, currentCallsite->methodLen);
+    lineBuffer.append(ANSICOLOR_YELLOW);
+    lineBuffer.append(startStopSuffix);
+    _writeColorReset();
 }
 
-String EZLog::getBGColor() const {
+const String& EZLog::getBGColor() const {
     if (taskID == 1) return TaskIdBGColors[0];
 
     // Rolliere ab Index 1 (also ab dem 2. Eintrag)
@@ -340,32 +984,40 @@ String EZLog::getBGColor() const {
     return TaskIdBGColors[colorIdx];
 }
 
-void EZLog::_msg(Loglevel loglevel, String msg, const boolean isStart, const boolean isEnd) {
-    if (!config.enabled) return;
+void EZLog::_msg(const Loglevel loglevel, const char* msg, const size_t len, const boolean newline,
+                 const boolean isStart, const boolean isEnd) {
+    if (!_config().enabled) return;
 
-    if (lastPrefix.equals("")) {
-        const String errorMsg = "EZLog ERROR: Log-Aufruf ohne gültigen Prefix (kein start() erfolgt?)";
-        config.customErrorAction(taskID, errorMsg);
-        Serial.println(errorMsg);
+    if (currentCallsite == nullptr) {
+        const char* errorMsg = "EZLog ERROR: Log-Aufruf ohne gültigen Prefix (kein start() erfolgt?)";
+        if (_config().customErrorAction) _config().customErrorAction(taskID, errorMsg);
+        _writeError(errorMsg);
         esp_backtrace_print(30);
-        if (config.restartESPonError) {
+        if (_config().restartESPonError) {
             abort();
         }
     }
 
     /** Handling Mutliline-Messages */
-    constexpr char crlf = '\n';
-    const size_t occurrences = std::count(msg.begin(), msg.end(), crlf);
-
-    if (occurrences > 1) {
-        std::istringstream tokenStream(msg.c_str());
-        std::string msgPart;
-        while (std::getline(tokenStream, msgPart, '\n')) {
-            if (!msgPart.empty() && _shouldLog(loglevel)) {
-                // filling multiLineBuffer:
-                _msg(loglevel, String(msgPart.c_str()) + '\n', isStart, isEnd);
-
-                newLineStarted = true;
+    const char* msgEnd = msg + len;
+    const auto firstBreak = static_cast<const char*>(memchr(msg, '\n', len));
+    const bool multiline = firstBreak != nullptr
+                           && (newline || memchr(firstBreak + 1, '\n', msgEnd - firstBreak - 1) != nullptr);
+
+    if (multiline) {
+        // Each line is passed on as a slice of msg (empty lines are skipped):
+        if (_shouldLog(loglevel)) {
+            const char* lineStart = msg;
+            const char* lineEnd = firstBreak;
+            while (lineStart < msgEnd) {
+                if (lineEnd == nullptr) lineEnd = msgEnd;
+                if (lineEnd > lineStart) {
+                    _msg(loglevel, lineStart, lineEnd - lineStart, true, isStart, isEnd);
+                    newLineStarted = true;
+                }
+                lineStart = lineEnd + 1;
+                lineEnd = lineStart < msgEnd
+                              ? static_cast<const char*>(memchr(lineStart, '\n', msgEnd - lineStart)) : nullptr;
             }
         }
 
@@ -373,51 +1025,91 @@ void EZLog::_msg(Loglevel loglevel, String msg, const boolean isStart, const boo
         return;
     }
 
-    if (occurrences == 0) {
-        multilineBuffer += msg;
+    if (firstBreak == nullptr && !newline) {
+        multilineBuffer.append(msg, len);
         lastloglevel = loglevel;
         return;
     }
 
-    // occurrences == 1:
+    // a single line:
     if (loglevel != lastloglevel) {
         if (!newLineStarted) {
             newLineStarted = true;
         }
         // Der sollte eigentlich eh leer sein, trotzdem...
-        multilineBuffer = "";
+        multilineBuffer.clear();
     }
 
-    if (xSemaphoreTake(logSemaphoreMessage, 1000 / portTICK_PERIOD_MS) != pdTRUE) {
-        Serial.println("Log-Semaphore not available!");
-        esp_backtrace_print(30);
-        while (true) {
-            delay(1);
-        }
+    // Rate limit / repeats: dropped before the lock and the formatting
+    const bool passesFilter = _shouldLog(loglevel) || loglevel <= Loglevel::WARN;
+    if (passesFilter && _suppressed(loglevel, msg, len, isStart || isEnd)) {
+        multilineBuffer.clear();
+        newLineStarted = true;
+        lastloglevel = loglevel;
+        return;
+    }
+
+    // The line is assembled in the buffers of this task without any lock. Only the finished line is committed
+    // (see _commit()), so lines of different tasks never interleave and the lock is held for one copy.
+    if (passesFilter && _config().crashRing) {
+        const size_t msgLen = (len > 0 && msg[len - 1] == '\n') ? len - 1 : len;
+        const uint8_t flags = isStart ? LogCrashRing::FLAG_START : (isEnd ? LogCrashRing::FLAG_END : 0);
+        LogCrashRing::record(currentCallsite, static_cast<uint8_t>(taskID), loglevel, flags, multilineBuffer.data(),
+                             multilineBuffer.length(), msg, msgLen);
     }
 
-    const bool shouldLog = _shouldLog(loglevel) || loglevel <= Loglevel::WARN;
+    // Formats, which are wanted by at least one sink. Each one is rendered only once:
+    constexpr uint8_t binaryFormat = 1u << (int)LogFormat::BINARY;
+    const uint8_t formats = passesFilter ? _sinkFormats(loglevel) : 0;
+
+    // Memory-Info: sampled once for all formats (see LogMemInfo)
+    LogMemSample memInfo{};
+    LogMemSample memPrevious{LogMemInfo::NONE, 0, 0};
+    bool printMemInfo = false;
+    if (_config().addMemInfo && formats != 0) {
+        memInfo = LogMemInfo::get(_config().memInfoSampling, _config().memInfoIntervalMs);
+        printMemInfo = !_config().memInfoOnlyChanges || LogMemInfo::exchangePrinted(memInfo, memPrevious);
+    }
+
+    bool committed = true;
+    if (formats & binaryFormat) {
+        committed = _msgBinary(loglevel, msg, len, isStart, isEnd, printMemInfo ? &memInfo : nullptr);
+    }
+
+    // Only binary sinks (every sink accepts ERROR): no text to assemble
+    if ((_sinkFormats(Loglevel::ERROR) & ~binaryFormat) == 0) {
+        if (!committed) _dropLine(loglevel);
+        multilineBuffer.clear();
+        newLineStarted = true;
+        lastloglevel = loglevel;
+        return;
+    }
+
+    const bool shouldLog = (formats & ~binaryFormat) != 0;
 
     if (newLineStarted) {
         /**
          * [TaskID] Timestamp [Loglevel] <<indent>>
          */
         if (shouldLog) {
-            Serial.print(ANSICOLOR_RESET); // Reset everything
+            lineBuffer.append(ANSICOLOR_RESET); // Reset everything
 
             // TaskID - Text-Color:
-            int colorIdx = taskID <= TaskIdColors.size() ? taskID - 1 : 0;
-            Serial.print("[" + TaskIdColors[colorIdx] + String(taskID) + "] ");
+            int colorIdx = taskID <= (int)TaskIdColors.size() ? taskID - 1 : 0;
+            lineBuffer.append('[');
+            lineBuffer.append(TaskIdColors[colorIdx]);
+            lineBuffer.appendNumber(taskID);
+            lineBuffer.append("] ");
 
             // Timestamp:
-            Serial.print(ansiColorReset() + ts());
+            _writeColorReset();
+            _writeTimestamp();
 
-            Serial.print(loglevelPrefixColors[(int)loglevel]);
-            Serial.print(loglevelStrings[(int)loglevel]);
-            Serial.print(ansiColorReset());
+            lineBuffer.append(loglevelPrefixColors[(int)loglevel]);
+            lineBuffer.append(loglevelStrings[(int)loglevel]);
+            _writeColorReset();
 
-            int indent = std::min(std::max(depth * 4, 0), 80);
-            Serial.print(std::string(indent, ' ').c_str());
+            lineBuffer.appendRepeated(' ', std::min(std::max(depth, 0), 20) * _config().indentWidth);
         }
 
         newLineStarted = false;
@@ -426,11 +1118,11 @@ void EZLog::_msg(Loglevel loglevel, String msg, const boolean isStart, const boo
          * [START] / [END] (optional)
          */
         if (shouldLog) {
-            if (!lastPrefix.equals("")) {
-                Serial.print(_colorPrefix(lastPrefix, isStart, isEnd));
+            if (currentCallsite != nullptr) {
+                _writeColorPrefix(isStart, isEnd);
 
-                if (!msg.equals("") && !isStart && !isEnd) {
-                    Serial.print(": ");
+                if ((len > 0 || newline) && !isStart && !isEnd) {
+                    lineBuffer.append(": ");
                 }
             }
 
@@ -441,97 +1133,643 @@ void EZLog::_msg(Loglevel loglevel, String msg, const boolean isStart, const boo
     }
 
     /**
-     * [FREE MEM] (optional)
-     */
-    _addFreeMemToMessage();
-
-    /**
-     * MULTILINEBUFFER (= MSG)
+     * [FREE MEM] (optional) + MULTILINEBUFFER + MSG
      */
     if (shouldLog) {
-        Serial.print(ansiColorReset());
-        Serial.print(multilineBuffer);
-        Serial.print(ansiColorReset());
-        Serial.print(loglevelTextColors[(int)loglevel]);
+        _writeColorReset();
+        _writeFreeMem(printMemInfo ? &memInfo : nullptr,
+                      memPrevious.heapFree != LogMemInfo::NONE ? &memPrevious : nullptr);
+        lineBuffer.append(multilineBuffer);
+        _writeColorReset();
+        lineBuffer.append(loglevelTextColors[(int)loglevel]);
+
+        if (isEnd) {
+            // Duration of the function:
+            lineBuffer.append(ANSICOLOR_RESET);
+            lineBuffer.append(" ");
+            lineBuffer.append(ANSICOLOR_BRIGHT_BLACK);
+            lineBuffer.append(" (");
+            _writeDuration(lastDuration);
+            if (_config().printSelfTime) {
+                lineBuffer.append(", self ");
+                _writeDuration(lastSelfTime);
+            }
+            lineBuffer.append(')');
+            lineBuffer.append(ANSICOLOR_RESET);
+        }
 
-        if (msg.endsWith("\n")) {
-            Serial.print(msg.substring(0, msg.length() - 1) + ANSICOLOR_RESET + "\n");
+        if (newline || (len > 0 && msg[len - 1] == '\n')) {
+            lineBuffer.append(msg, newline ? len : len - 1);
+            lineBuffer.append(ANSICOLOR_RESET);
+            lineBuffer.append('\n');
             newLineStarted = true;
         } else {
-            Serial.print(msg);
+            lineBuffer.append(msg, len);
         }
     }
-    multilineBuffer = "";
+    multilineBuffer.clear();
 
     lastloglevel = loglevel;
 
+    if (!_commitLine(loglevel)) committed = false;
+    if (!committed) _dropLine(loglevel);
+}
+
+/**
+ * Returns true, if the line is dropped by the rate limit or is a repeat of the previous message of the callsite.
+ * Writes the notices for the lines, which were dropped/repeated before, in front of a line, which passes.
+ */
+bool EZLog::_suppressed(const Loglevel loglevel, const char* msg, size_t len, const bool isStartEnd) {
+    if (bypassLimits || currentCallsite == nullptr) return false;
+
+    const bool checkRepeats = _config().suppressRepeats && !isStartEnd;
+    uint32_t hash = 0;
+    if (checkRepeats) {
+        if (len > 0 && msg[len - 1] == '\n') len--;
+        hash = LogRateLimit::hash(loglevel, multilineBuffer.data(), multilineBuffer.length(), msg, len);
+        if (currentCallsite->lastMessageHash.load(std::memory_order_relaxed) == hash) {
+            currentCallsite->repeatLoglevel.store(static_cast<uint8_t>(loglevel), std::memory_order_relaxed);
+            currentCallsite->repeatCount.fetch_add(1, std::memory_order_relaxed);
+            repeatedCount.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    const uint16_t rateLimit = _rateLimit(currentCallsite);
+    if (rateLimit > 0 && !LogRateLimit::acquire(currentCallsite, rateLimit, _config().rateLimitBurst, millis())) {
+        currentCallsite->rateDropped.fetch_add(1, std::memory_order_relaxed);
+        rateLimitedCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Only a line, which is written, is the message, that the next ones are compared with:
+    if (checkRepeats) {
+        currentCallsite->lastMessageHash.store(hash, std::memory_order_relaxed);
+        _flushRepeats(currentCallsite);
+    }
+    if (rateLimit == 0) return false;
+
+    const uint32_t dropped = currentCallsite->rateDropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        char notice[48];
+        snprintf(notice, sizeof(notice), "%u line%s dropped by the rate limit", static_cast<unsigned>(dropped),
+                 dropped == 1 ? "" : "s");
+        _writeNotice(currentCallsite, loglevel, notice);
+    }
+    return false;
+}
+
+/**
+ * Writes "last message repeated N times" for the callsite, if its last message was repeated
+ */
+void EZLog::_flushRepeats(const LogCallsite* callsite) {
+    const uint32_t repeats = callsite->repeatCount.exchange(0, std::memory_order_relaxed);
+    if (repeats == 0) return;
+
+    char notice[48];
+    snprintf(notice, sizeof(notice), "last message repeated %u time%s", static_cast<unsigned>(repeats),
+             repeats == 1 ? "" : "s");
+    _writeNotice(callsite, static_cast<Loglevel>(callsite->repeatLoglevel.load(std::memory_order_relaxed)), notice);
+}
+
+/**
+ * Writes a line of the callsite in front of the current one. If that one is already started in multilineBuffer, it's
+ * only hidden meanwhile: the notice is a single line, which doesn't append anything to multilineBuffer.
+ */
+void EZLog::_writeNotice(const LogCallsite* callsite, const Loglevel loglevel, const char* text) {
+    const LogCallsite* current = currentCallsite;
+    const Loglevel currentLoglevel = lastloglevel;
+    const size_t pending = multilineBuffer.length();
+    multilineBuffer.shrink(0);
+
+    currentCallsite = callsite;
+    bypassLimits = true;
+    _msg(loglevel, text, strlen(text), true);
+    bypassLimits = false;
+
+    currentCallsite = current;
+    lastloglevel = currentLoglevel;
+    multilineBuffer.grow(pending);
+}
+
+/**
+ * Binary mode: Sends the line as compact record, the text is rebuilt on the host (see LogBinary.h).
+ * Returns false, if the record couldn't be committed (see _commit()).
+ */
+bool EZLog::_msgBinary(const Loglevel loglevel, const char* msg, const size_t len, const boolean isStart,
+                       const boolean isEnd, const LogMemSample* memInfo) {
+    // The record is encoded in the (still empty) lineBuffer: it's committed, before the text is assembled there
+    auto* record = reinterpret_cast<uint8_t*>(lineBuffer.tail());
+    const size_t recordSize = lineBuffer.available();
+
+    // The name of a callsite is written by _writeToSink() in front of its first line in each sink. Only without an
+    // ID (table full), it's sent before each line (to all binary sinks, independent of their loglevel):
+    LogBinaryLine line;
+    if (currentCallsite != nullptr) {
+        int32_t id = currentCallsite->binaryId.load(std::memory_order_relaxed);
+        if (id < 0) {
+            id = LogBinary::callsiteId(currentCallsite->name, currentCallsite->nameLen);
+            currentCallsite->binaryId.store(id, std::memory_order_relaxed);
+        }
+        line.callsiteId = static_cast<uint16_t>(id);
+        if (line.callsiteId == 0) {
+            const size_t recordLen = LogBinary::encodeCallsite(record, recordSize, 0, currentCallsite->name,
+                                                               currentCallsite->nameLen);
+            _commit(reinterpret_cast<const char*>(record), recordLen, Loglevel::ERROR, LogFormat::BINARY);
+        }
+    }
+
+    line.timestamp = millis();
+    line.taskID = static_cast<uint8_t>(taskID);
+    line.depth = static_cast<uint8_t>(std::min(std::max(depth, 0), 255));
+    line.loglevel = loglevel;
+    line.isStart = isStart;
+    line.isEnd = isEnd;
+    line.duration = lastDuration;
+    line.hasSelfTime = _config().printSelfTime;
+    line.selfTime = lastSelfTime;
+    if (memInfo != nullptr) {
+        line.hasMemInfo = true;
+        line.heapFree = memInfo->heapFree;
+        line.heapLargestBlock = memInfo->heapLargestBlock;
+        line.psramFree = memInfo->psramFree;
+    }
+
+    // Start/End-Messages don't have a text, the rest is sent without the trailing newline:
+    size_t msgLen = (isStart || isEnd) ? 0 : len;
+    if (msgLen > 0 && msg[msgLen - 1] == '\n') msgLen--;
+
+    const size_t recordLen = LogBinary::encodeLine(record, recordSize, line, multilineBuffer.data(),
+                                                   multilineBuffer.length(), msg, msgLen);
+    return _commit(reinterpret_cast<const char*>(record), recordLen, loglevel, LogFormat::BINARY);
+}
+
+/**
+ * Finishes the assembled line and commits it. Returns false, if it couldn't be committed (see _commit()).
+ */
+bool EZLog::_commitLine(const Loglevel loglevel) {
+    if (lineBuffer.empty()) return true;
+
+    if (lineBuffer.isTruncated()) lineBuffer.terminateLine();
+    if (_config().terseColors) lineBuffer.compactColors();
+    const bool committed = _commit(lineBuffer.data(), lineBuffer.length(), loglevel, LogFormat::TEXT);
+    lineBuffer.clear();
+    return committed;
+}
+
+/**
+ * Writes a finished line (or binary record) as a whole: under logSemaphoreMessage, which is only held for writing
+ * it to the sinks - in async mode into the ring buffer of this task, without lock.
+ * Returns false, if the output stalled for a second (the lock was not available): the line is dropped, instead of
+ * blocking the task any longer.
+ */
+bool EZLog::_commit(const char* data, const size_t len, const Loglevel loglevel, const LogFormat format) {
+    if (_config().asyncMode) {
+        _output(data, len, loglevel, format);
+        return true;
+    }
+
+    if (xSemaphoreTake(logSemaphoreMessage, 1000 / portTICK_PERIOD_MS) != pdTRUE) return false;
+
+    // BLOCK / DROP_BELOW: a full sink is waited for without the lock, so the other tasks can write meanwhile
+    // (to the sinks, which are not full) - only this task waits for the slow sink:
+    const bool waits = _config().backpressurePolicy == BackpressurePolicy::BLOCK ||
+                       (_config().backpressurePolicy == BackpressurePolicy::DROP_BELOW &&
+                        loglevel <= _config().backpressureLoglevel);
+    if (waits) {
+        bool writable = _sinksWritable(data, len, loglevel, format);
+        const unsigned long start = writable ? 0 : millis();
+        while (!writable && millis() - start < _config().backpressureTimeoutMs) {
+            xSemaphoreGive(logSemaphoreMessage);
+            delay(1);
+            if (xSemaphoreTake(logSemaphoreMessage, 1000 / portTICK_PERIOD_MS) != pdTRUE) return false;
+            writable = _sinksWritable(data, len, loglevel, format);
+        }
+        sinkCheck = writable ? SinkCheck::WRITABLE : SinkCheck::TIMED_OUT;
+    }
+    _output(data, len, loglevel, format);
+    sinkCheck = SinkCheck::NONE;
     xSemaphoreGive(logSemaphoreMessage);
+    return true;
 }
 
-void EZLog::_addFreeMemToMessage() {
-    if (!config.addMemInfo) return;
+/**
+ * Writes data directly to the sinks or into the ring buffer of this task (async mode).
+ * passThrough = true: text, which is also written to binary sinks (the decoder passes it through).
+ */
+void EZLog::_output(const char* data, const size_t len, const Loglevel loglevel, const LogFormat format,
+                    const bool passThrough) {
+    if (len == 0) return;
+
+    if (_config().asyncMode) {
+        // The writer task needs loglevel and format to pick the sinks:
+        const uint8_t tag = (int)loglevel | ((int)format << 3) | (passThrough ? 0x80 : 0);
+        _pushAsync(data, len, loglevel, tag);
+    } else {
+        _writeToSinks(data, len, loglevel, format, passThrough);
+    }
+}
+
+void EZLog::_pushAsync(const char* data, const size_t len, const Loglevel loglevel, const uint8_t tag) {
+    if (ringBuffer == nullptr) {
+        if (xSemaphoreTake(logSemaphoreAsync, portMAX_DELAY) != pdTRUE) return;
+        ringBuffer = new LogRingBuffer(_config().asyncBufferSize);
+        asyncInstances.push_back(this);
+        xSemaphoreGive(logSemaphoreAsync);
+    }
 
-    multilineBuffer =
-        ANSICOLOR_BRIGHT_YELLOW + " [ " +
-        ANSICOLOR_WHITE + String(formatNumber(static_cast<int>(heap_caps_get_free_size(MALLOC_CAP_DMA)) / 1024)) + " kB " +         // Free HEAP
-        "(" +
-        ANSICOLOR_CYAN + String(formatNumber(static_cast<int>(heap_caps_get_largest_free_block(MALLOC_CAP_DMA)) / 1024)) + " kB" + ANSICOLOR_WHITE +        // largest free  HEAP Block
-        ")" +
+    while (!ringBuffer->push(data, len, _config().asyncOverflowPolicy, tag)) {
+        if (_config().asyncOverflowPolicy != OverflowPolicy::BLOCK) break;
 
-        ANSICOLOR_BRIGHT_YELLOW + " / " +
-        ANSICOLOR_WHITE + String(formatNumber(static_cast<int>(heap_caps_get_free_size(MALLOC_CAP_8BIT)) / 1024)) + " kB " +        // PSRAM
-        ANSICOLOR_BRIGHT_YELLOW + "] " +
-        multilineBuffer;
+        // BLOCK: wait for the writer task (or write it ourselves, if there is none)
+        if (asyncWriterTask == nullptr || asyncWriterTask == xTaskGetCurrentTaskHandle()) {
+            _drainAsyncBuffers();
+        } else {
+            xTaskNotifyGive(asyncWriterTask);
+            vTaskDelay(1);
+        }
+    }
+
+    // Wake up the writer early on errors or if the buffer gets full:
+    if (asyncWriterTask != nullptr &&
+        (loglevel == Loglevel::ERROR || ringBuffer->used() > ringBuffer->capacity() / 2)) {
+        xTaskNotifyGive(asyncWriterTask);
+    }
+}
+
+void EZLog::_startAsyncWriter() {
+    if (asyncWriterTask != nullptr) return;
+    xTaskCreate(_asyncWriterTask, "EZLogWriter", _config().asyncTaskStackSize, nullptr,
+                _config().asyncTaskPriority, &asyncWriterTask);
 }
 
-bool EZLog::_shouldLog(const String& prefix, const Loglevel requestedLoglevel) {
-    if (config.overrideLogAll) return true;
+/**
+ * Background task: Writes the ring buffers of all tasks to the sinks (async mode) and polls the sinks. In sync mode,
+ * it only runs for sinks, which want to be polled (f.e. FileSink writes its buffer after flushIntervalMs).
+ */
+void EZLog::_asyncWriterTask(void*) {
+    while (true) {
+        uint32_t flushIntervalMs;
+        {
+            ReadSection section;
+            flushIntervalMs = _config().asyncFlushIntervalMs;
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(std::max<uint32_t>(flushIntervalMs, 1)));
+        _drainAsyncBuffers();
+    }
+}
 
-    // Hilfsfunktion, die entweder nullptr oder einen Zeiger auf ein bool zurückgibt
-    std::function<const bool*(const std::vector<LoggingElement>&)> searchLoggingElements;
-    searchLoggingElements = [&](const std::vector<LoggingElement>& elements) -> const bool* {
-        for (const auto& elem : elements) {
-            std::string searchPrefix = prefix.c_str();
-            std::string name = elem.filter.c_str();
+void EZLog::_drainAsyncBuffers() {
+    if (xSemaphoreTake(logSemaphoreMessage, 1000 / portTICK_PERIOD_MS) != pdTRUE) return;
+    if (xSemaphoreTake(logSemaphoreAsync, 1000 / portTICK_PERIOD_MS) != pdTRUE) {
+        xSemaphoreGive(logSemaphoreMessage);
+        return;
+    }
+    _writeAsyncBuffers();
+    xSemaphoreGive(logSemaphoreAsync);
+    xSemaphoreGive(logSemaphoreMessage);
+}
 
-            if (searchPrefix.find(name) == 0) {
-                // In Logging-Config gefunden: Ergebnis speichern
-                static bool result;
-                result = (requestedLoglevel <= elem.loglevel);
-                return &result;
+/**
+ * Writes the ring buffers of all tasks to the sinks. Only called under logSemaphoreMessage and logSemaphoreAsync.
+ */
+void EZLog::_writeAsyncBuffers() {
+    static char line[EZLOG_MAX_LINE_LENGTH];
+
+    // Round robin: one line per task and pass, so a chatty task can't starve the others
+    bool found = true;
+    while (found) {
+        found = false;
+        for (EZLog* instance : asyncInstances) {
+            uint8_t tag = 0;
+            const size_t len = instance->ringBuffer->pop(line, sizeof(line), &tag);
+            if (len > 0) {
+                _writeToSinks(line, len, static_cast<Loglevel>(tag & 0x07), static_cast<LogFormat>((tag >> 3) & 0x03),
+                              (tag & 0x80) != 0);
+                found = true;
             }
+        }
+    }
+    for (LogSink* sink : _sinks()) sink->poll();
+}
 
-            // Rekursiv in Unterelementen suchen
-            if (!elem.subElements.empty()) {
-                const bool* result = searchLoggingElements(elem.subElements);
-                if (result != nullptr) {
-                    return result;
-                }
+const std::vector<LogSink*>& EZLog::_sinks() {
+    return _config().sinks.empty() ? defaultSinks : _config().sinks;
+}
+
+/**
+ * Bitmask (1 << LogFormat) of the formats, which are needed for a line with this loglevel.
+ * Read without lock, so it's taken from sinkFormats (see _updateSinkFormats()) and not from the sinks.
+ */
+uint8_t EZLog::_sinkFormats(const Loglevel loglevel) {
+    return sinkFormats[(int)loglevel].load(std::memory_order_relaxed);
+}
+
+/**
+ * Collects the formats of the sinks per loglevel. Only called under logSemaphoreMessage (by _applyConfig()).
+ */
+void EZLog::_updateSinkFormats() {
+    for (int level = (int)Loglevel::ERROR; level <= (int)Loglevel::VERBOSE; level++) {
+        uint8_t formats = 0;
+        for (const LogSink* sink : _sinks()) {
+            if (sink->accepts(static_cast<Loglevel>(level))) formats |= 1u << (int)sink->format;
+        }
+        sinkFormats[level].store(formats, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * Writes a rendered line to all sinks, which accept its loglevel and format. TEXT is converted once for PLAIN-sinks.
+ * Only called under logSemaphoreMessage (the buffer is shared).
+ */
+void EZLog::_writeToSinks(const char* data, const size_t len, const Loglevel loglevel, const LogFormat format,
+                          const bool passThrough) {
+    static char plain[EZLOG_MAX_LINE_LENGTH];
+    size_t plainLen = 0;
+    bool stripped = false;
+    bool lost = false;
+
+    if (dropsPending.load(std::memory_order_acquire)) _countPendingDrops();
+
+    for (LogSink* sink : _sinks()) {
+        if (!sink->accepts(loglevel)) continue;
+
+        if (sink->format == format || (passThrough && sink->format == LogFormat::BINARY)) {
+            lost |= !_writeToSink(sink, data, len, loglevel);
+        } else if (format == LogFormat::TEXT && sink->format == LogFormat::PLAIN) {
+            if (!stripped) {
+                plainLen = LogSink::stripColors(plain, sizeof(plain), data, len);
+                stripped = true;
             }
+            lost |= !_writeToSink(sink, plain, plainLen, loglevel);
+        }
+    }
+    if (lost) droppedCount[(int)loglevel].fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Writes the line, if the sink is writable in time (backpressurePolicy). Lines, which were dropped before,
+ * are reported in front of it. A binary sink gets the name of the callsite in front of its first line (in this sink:
+ * so neither a dropped line, nor a sink added later, nor a new file loses it).
+ */
+bool EZLog::_writeToSink(LogSink* sink, const char* data, const size_t len, const Loglevel loglevel) {
+    static uint8_t callsite[EZLOG_MAX_LINE_LENGTH];
+    char notice[64];
+    size_t noticeLen = 0;
+    const uint32_t unreported = sink->unreported.load(std::memory_order_relaxed);
+    if (unreported > 0) {
+        noticeLen = snprintf(notice, sizeof(notice), "EZLog: %u line%s dropped (output too slow)\r\n",
+                             static_cast<unsigned>(unreported), unreported == 1 ? "" : "s");
+    }
+    const uint16_t id = sink->format == LogFormat::BINARY ? LogBinary::lineCallsiteId(data, len) : 0;
+    const size_t callsiteLen = id != 0 && !sink->callsiteSent(id)
+                                   ? LogBinary::encodeCallsite(callsite, sizeof(callsite), id,
+                                                               LogBinary::callsiteName(id),
+                                                               strlen(LogBinary::callsiteName(id)))
+                                   : 0;
+
+    if (!_waitForSink(sink, noticeLen + callsiteLen + len, loglevel)) {
+        sink->countDropped(loglevel);
+        return false;
+    }
+    if (noticeLen > 0) {
+        sink->unreported.fetch_sub(unreported, std::memory_order_relaxed);
+        sink->write(notice, noticeLen, Loglevel::WARN);
+    }
+    if (callsiteLen > 0) {
+        sink->write(reinterpret_cast<const char*>(callsite), callsiteLen, loglevel);
+        sink->markCallsiteSent(id);
+    }
+    sink->write(data, len, loglevel);
+    return true;
+}
+
+/**
+ * True, if all sinks, which take the line, can write it without blocking (see _commit()).
+ * Only called under logSemaphoreMessage.
+ */
+bool EZLog::_sinksWritable(const char* data, const size_t len, const Loglevel loglevel, const LogFormat format) {
+    const uint16_t id = format == LogFormat::BINARY ? LogBinary::lineCallsiteId(data, len) : 0;
+    for (LogSink* sink : _sinks()) {
+        if (!sink->accepts(loglevel)) continue;
+        if (sink->format != format && !(format == LogFormat::TEXT && sink->format == LogFormat::PLAIN)) continue;
+
+        // Room for the "N lines dropped"-notice and the name of the callsite in front of the line (see _writeToSink()):
+        const size_t noticeLen = sink->unreported.load(std::memory_order_relaxed) > 0 ? 64 : 0;
+        const size_t callsiteLen = id != 0 && !sink->callsiteSent(id)
+                                       ? LogBinary::MAX_HEADER_SIZE + 3 + strlen(LogBinary::callsiteName(id))
+                                       : 0;
+        if (!sink->canWrite(noticeLen + callsiteLen + len)) return false;
+    }
+    return true;
+}
+
+/**
+ * Returns false, if the line has to be dropped, because the sink is not writable (depending on backpressurePolicy).
+ * Waits under the lock only for the writer task (async mode) and the reports: _commit() waits without the lock
+ * and sets sinkCheck.
+ */
+bool EZLog::_waitForSink(LogSink* sink, const size_t len, const Loglevel loglevel) {
+    if (sinkCheck == SinkCheck::WRITABLE || sink->canWrite(len)) return true;
+    if (_config().backpressurePolicy == BackpressurePolicy::DROP) return false;
+    if (_config().backpressurePolicy == BackpressurePolicy::DROP_BELOW && loglevel > _config().backpressureLoglevel) {
+        return false;
+    }
+    if (sinkCheck == SinkCheck::TIMED_OUT) return false;
+
+    const unsigned long start = millis();
+    while (millis() - start < _config().backpressureTimeoutMs) {
+        delay(1);
+        if (sink->canWrite(len)) return true;
+    }
+    return false;
+}
+
+/**
+ * A line, which couldn't be written, because the output lock was not available in time.
+ * The sinks must not be touched without the lock, so they are counted by the next task, which gets it.
+ */
+void EZLog::_dropLine(const Loglevel loglevel) {
+    droppedCount[(int)loglevel].fetch_add(1, std::memory_order_relaxed);
+    pendingDrops[(int)loglevel].fetch_add(1, std::memory_order_relaxed);
+    dropsPending.store(true, std::memory_order_release);
+}
+
+/**
+ * Counts the lines of _dropLine() at the sinks (reported by "N lines dropped"). Only called under the output lock.
+ */
+void EZLog::_countPendingDrops() {
+    dropsPending.store(false, std::memory_order_relaxed);
+    for (int level = (int)Loglevel::ERROR; level <= (int)Loglevel::VERBOSE; level++) {
+        const uint32_t dropped = pendingDrops[level].exchange(0, std::memory_order_acq_rel);
+        if (dropped == 0) continue;
+        for (LogSink* sink : _sinks()) {
+            if (sink->accepts(static_cast<Loglevel>(level))) sink->countDropped(static_cast<Loglevel>(level), dropped);
+        }
+    }
+}
+
+size_t EZLog::SinkPrint::write(const uint8_t c) {
+    line.append(static_cast<char>(c));
+    if (c == '\n' || line.length() >= EZLOG_MAX_LINE_LENGTH) {
+        _writeToSinks(line.data(), line.length(), Loglevel::ERROR, LogFormat::TEXT, true);
+        line.clear();
+    }
+    return 1;
+}
+
+size_t EZLog::SinkPrint::write(const uint8_t* buffer, const size_t size) {
+    for (size_t i = 0; i < size; i++) write(buffer[i]);
+    return size;
+}
+
+/**
+ * Internal errors: written to all sinks immediately (not through the ring buffer), under the output lock.
+ * If the lock is not available within 100 ms (f.e. the error happened, while it is held), the error goes only to
+ * Serial, which has its own lock - the other sinks are never written without the lock.
+ */
+void EZLog::_writeError(const char* text) {
+    const size_t len = strlen(text);
+    if (xSemaphoreTake(logSemaphoreMessage, 100 / portTICK_PERIOD_MS) != pdTRUE) {
+        Serial.write(reinterpret_cast<const uint8_t*>(text), len);
+        Serial.write(reinterpret_cast<const uint8_t*>("\r\n"), 2);
+        Serial.flush();
+        return;
+    }
+    for (LogSink* sink : _sinks()) {
+        sink->write(text, len, Loglevel::ERROR);
+        sink->write("\r\n", 2, Loglevel::ERROR);
+        sink->flush();
+    }
+    xSemaphoreGive(logSemaphoreMessage);
+}
+
+/**
+ * Writes " [ heap kB (largest block kB) / PSRAM kB ] " - or the differences to previous (memInfoOnlyChanges)
+ */
+void EZLog::_writeFreeMem(const LogMemSample* sample, const LogMemSample* previous) {
+    if (sample == nullptr) return;
+
+    const auto appendValue = [this, previous](const uint32_t value, const uint32_t previousValue) {
+        if (previous == nullptr) {
+            lineBuffer.appendGroupedNumber(static_cast<int32_t>(value));
+            return;
         }
-        return nullptr; // Kein Eintrag gefunden
+        const auto delta = static_cast<int32_t>(value - previousValue);
+        if (delta >= 0) lineBuffer.append('+');
+        lineBuffer.appendGroupedNumber(delta);
     };
 
-    const bool* found = searchLoggingElements(config.customLoggingElements);
-    if (found != nullptr) {
-        return *found;
+    lineBuffer.append(ANSICOLOR_BRIGHT_YELLOW);
+    lineBuffer.append(" [ ");
+    lineBuffer.append(ANSICOLOR_WHITE);
+    appendValue(sample->heapFree, previous ? previous->heapFree : 0);                    // Free HEAP
+    lineBuffer.append(" kB (");
+    lineBuffer.append(ANSICOLOR_CYAN);
+    appendValue(sample->heapLargestBlock, previous ? previous->heapLargestBlock : 0);    // largest free  HEAP Block
+    lineBuffer.append(" kB");
+    lineBuffer.append(ANSICOLOR_WHITE);
+    lineBuffer.append(")");
+    lineBuffer.append(ANSICOLOR_BRIGHT_YELLOW);
+    lineBuffer.append(" / ");
+    lineBuffer.append(ANSICOLOR_WHITE);
+    appendValue(sample->psramFree, previous ? previous->psramFree : 0);                  // PSRAM
+    lineBuffer.append(" kB ");
+    lineBuffer.append(ANSICOLOR_BRIGHT_YELLOW);
+    lineBuffer.append("] ");
+}
+
+/**
+ * Compiles the customLoggingElements into a new LogFilter and swaps it in. Returns the previous filter, which is
+ * deleted like the old config (see _waitForReaders()).
+ */
+const LogFilter* EZLog::_compileFilter() {
+    const LogFilter* compiled = new LogFilter(_config().customLoggingElements);
+    const LogFilter* previous = filter.exchange(compiled);
+
+    // Invalidates the cached decisions of all callsites (epoch 0 is skipped, it's the state of a new callsite):
+    uint32_t epoch = (configEpoch.load(std::memory_order_relaxed) + 1) & 0xFFFFFF;
+    if (epoch == 0) epoch = 1;
+    configEpoch.store(epoch, std::memory_order_release);
+    return previous;
+}
+
+/**
+ * Waits, until no task can still read the config/filter, which was replaced before: the readers count themselves
+ * in readers of a generation (see ReadSection). A reader may have read the generation long before it counts
+ * itself, so it can be in either counter - both are waited for. The generation is switched before each wait, so new
+ * readers (which already see the new config) go into the other counter and can't keep the waited one from draining.
+ * Sequentially consistent: either the wait sees a reader, or the reader sees the new pointers.
+ */
+void EZLog::_waitForReaders() {
+    for (int i = 0; i < 2; i++) {
+        const uint32_t generation = readerGeneration.fetch_add(1) & 1;
+        while (readers[generation].load() != 0) delay(1);
+    }
+}
+
+/**
+ * Searches the current filter. Only inside of a ReadSection (the filter may be replaced meanwhile).
+ */
+bool EZLog::_findFilter(const char* prefix, Loglevel& loglevel, uint16_t* rateLimit) {
+    const LogFilter* current = filter.load();
+    return current != nullptr && current->find(prefix, loglevel, rateLimit);
+}
+
+bool EZLog::_shouldLog(const char* prefix, const Loglevel requestedLoglevel) {
+    if (_config().overrideLogAll) return true;
+
+    Loglevel loglevel;
+    if (_findFilter(prefix, loglevel)) {
+        return requestedLoglevel <= loglevel;
     }
 
     // Fallback auf Default-Loglevel
-    return requestedLoglevel <= config.loglevel;
+    return requestedLoglevel <= _config().loglevel;
 }
 
 
+/**
+ * Same as _shouldLog(callsite->name, ...), but the decision is cached in the callsite until the next updateConfig()
+ */
+bool EZLog::_shouldLog(const LogCallsite* callsite, const Loglevel requestedLoglevel) {
+    const uint32_t epoch = configEpoch.load(std::memory_order_acquire);
+    uint32_t state = callsite->filterState.load(std::memory_order_acquire);
+    if ((state >> 8) != epoch) {
+        // One search for all loglevels (same result as _shouldLog(callsite->name, level) for each of them):
+        uint16_t rateLimit = 0;
+        Loglevel loglevel = Loglevel::VERBOSE;
+        if (!_config().overrideLogAll && !_findFilter(callsite->name, loglevel, &rateLimit)) loglevel = _config().loglevel;
+
+        uint32_t mask = 0;
+        for (int level = (int)Loglevel::ERROR; level <= (int)loglevel; level++) mask |= 1u << level;
+        state = (epoch << 8) | mask;
+
+        callsite->rateLimit.store(rateLimit > 0 ? rateLimit : _config().rateLimit, std::memory_order_relaxed);
+        callsite->filterState.store(state, std::memory_order_release);
+    }
+    return (state & (1u << (int)requestedLoglevel)) != 0;
+}
+
+/**
+ * Rate limit of the callsite (LoggingElement::rateLimit or LoggingConfig::rateLimit), cached like the filter
+ */
+uint16_t EZLog::_rateLimit(const LogCallsite* callsite) {
+    _shouldLog(callsite, Loglevel::ERROR);
+    return callsite->rateLimit.load(std::memory_order_relaxed);
+}
+
 bool EZLog::_shouldLog(const Loglevel loglevel) const {
-    if (!lastPrefix.equals("")) {
-        return _shouldLog(lastPrefix, loglevel);
+    if (currentCallsite != nullptr) {
+        return _shouldLog(currentCallsite, loglevel);
     }
     return true;
 }
 
 
 void EZLog::_freeMem(const String& prefix, const bool inBytes) {
-    if (!_shouldLog(prefix, Loglevel::DEBUG)) return;
+    ReadSection section;
+    if (!_shouldLog(prefix.c_str(), Loglevel::DEBUG)) return;
 
     const int freePSRam = esp_get_free_heap_size() * (inBytes ? 1 : 1.0 / 1024.0);
     const int freeHeap = heap_caps_get_free_size(MALLOC_CAP_DMA) * (inBytes ? 1 : 1.0 / 1024.0);
@@ -539,22 +1777,31 @@ void EZLog::_freeMem(const String& prefix, const bool inBytes) {
     const String unit = inBytes ? "B" : "kB";
     const int largestFreeBlock = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT) * (inBytes ? 1 : 1.0 / 1024.0);
     //    if (!newLineStarted) {
-    Serial.println();
+    String line = "\r\n";
     //        newLineStarted = true;
     //    }
     if (!prefix.equals("")) {
-        Serial.print(String(prefix));
-        Serial.print(std::string((strlen(prefix.c_str()) < 40 ? 40 - strlen(prefix.c_str()) : 0), ' ').c_str());
+        line += String(prefix);
+        line += std::string((strlen(prefix.c_str()) < 40 ? 40 - strlen(prefix.c_str()) : 0), ' ').c_str();
     }
-    Serial.print("- Free Mem: " + ANSICOLOR_GREEN + formatNumber(freeHeap) + " " + unit + ANSICOLOR_RESET);
-    // Serial.print(" - Free Mem: " + ANSICOLOR_GREEN + formatNumber(freePSRam) + " " + unit + ANSICOLOR_WHITE);
-    Serial.print(",\tPSRAM: " + ANSICOLOR_GREEN + formatNumber(largestFreeBlock) + " " + unit +
-        ANSICOLOR_WHITE);
-    Serial.print(",\tDelta Heap: " + (String(freeHeap - lastMemoryUsageHeap)) + " " + unit);
-    Serial.print(",\tDelta PSRAM: " + (String(freePSRam - lastMemoryUsagePSRam)) + " " + unit);
-    Serial.print(",\tFree Stack: " + ANSICOLOR_GREEN + String(stackHighWaterMark) + ANSICOLOR_RESET);
-
-    Serial.println();
+    line += "- Free Mem: " + ANSICOLOR_GREEN + formatNumber(freeHeap) + " " + unit + ANSICOLOR_RESET;
+    // line += " - Free Mem: " + ANSICOLOR_GREEN + formatNumber(freePSRam) + " " + unit + ANSICOLOR_WHITE;
+    line += ",\tPSRAM: " + ANSICOLOR_GREEN + formatNumber(largestFreeBlock) + " " + unit +
+        ANSICOLOR_WHITE;
+    line += ",\tDelta Heap: " + (String(freeHeap - lastMemoryUsageHeap)) + " " + unit;
+    line += ",\tDelta PSRAM: " + (String(freePSRam - lastMemoryUsagePSRam)) + " " + unit;
+    line += ",\tFree Stack: " + ANSICOLOR_GREEN + String(stackHighWaterMark) + ANSICOLOR_RESET;
+
+    line += "\r\n";
+
+    // Like a line, but also for binary sinks (the decoder passes text through):
+    const bool async = _config().asyncMode;
+    if (!async && xSemaphoreTake(logSemaphoreMessage, 1000 / portTICK_PERIOD_MS) != pdTRUE) {
+        _dropLine(Loglevel::DEBUG);
+        return;
+    }
+    getInstanceForCurrentTask()->_output(line.c_str(), line.length(), Loglevel::DEBUG, LogFormat::TEXT, true);
+    if (!async) xSemaphoreGive(logSemaphoreMessage);
 
     lastMemoryUsageHeap = freeHeap;
     lastMemoryUsagePSRam = freePSRam;
@@ -564,21 +1811,39 @@ void EZLog::_freeMem() {
     _freeMem("");
 }
 
-String EZLog::ts() {
-    unsigned long millisVal = millis();
-    unsigned long hours = millisVal / 3600000;
-    unsigned long minutes = (millisVal % 3600000) / 60000;
-    unsigned long seconds = (millisVal % 60000) / 1000;
-    unsigned long milliseconds = millisVal % 1000;
-
-    char buffer[13]; // Platz für "HH:MM:SS.mmm"
-    snprintf(buffer, sizeof(buffer), "%02lu:%02lu:%02lu.%03lu", hours, minutes, seconds, milliseconds);
+/**
+ * Writes "HH:MM:SS.mmm " (see LoggingConfig::timestampFormat and LogTimestamp)
+ */
+void EZLog::_writeTimestamp() {
+    lineBuffer.append(ANSICOLOR_WHITE);
+    if (_config().timestampFormat == TimestampFormat::DELTA) {
+        const auto now = static_cast<uint32_t>(millis());
+        const uint32_t previous = lastLineMillis.exchange(now, std::memory_order_relaxed);
+        lineBuffer.append('+');
+        lineBuffer.appendNumber(previous != 0 ? now - previous : 0);
+    } else {
+        timestamp.append(lineBuffer, _config().timestampFormat);
+    }
+    lineBuffer.append(' ');
+    _writeColorReset();
+}
 
-    return ANSICOLOR_WHITE + buffer + " " + ansiColorReset();
+/**
+ * Writes a duration: "850us" (below 10 ms) or "1234ms"
+ */
+void EZLog::_writeDuration(const uint32_t micros) {
+    if (micros < 10000) {
+        lineBuffer.appendNumber(micros);
+        lineBuffer.append("us");
+    } else {
+        lineBuffer.appendNumber(micros / 1000);
+        lineBuffer.append("ms");
+    }
 }
 
-String EZLog::ansiColorReset() {
-    return ANSICOLOR_RESET + getBGColor();
+void EZLog::_writeColorReset() {
+    lineBuffer.append(ANSICOLOR_RESET);
+    lineBuffer.append(getBGColor());
 }
 
 // Funktion zum Aufteilen eines Strings anhand eines Delimiters
@@ -755,7 +2020,29 @@ String EZLog::loglevelTextColors[] = {
 
 int EZLog::lastMemoryUsageHeap = 0;
 int EZLog::lastMemoryUsagePSRam = 0;
-LoggingConfig EZLog::config;
+LoggingConfig EZLog::defaultConfig;
+std::atomic<const LoggingConfig*> EZLog::config{&EZLog::defaultConfig};
 int EZLog::lastTaskID = 0;
-SemaphoreHandle_t EZLog::logSemaphoreStartStop = xSemaphoreCreateMutex();
+std::atomic<EZLog*> EZLog::retiredInstances{nullptr};
+std::atomic<const LogFilter*> EZLog::filter{nullptr};
+std::atomic<uint32_t> EZLog::readers[2] = {};
+// Before init(): the default sink (Serial, TEXT) takes every loglevel
+std::atomic<uint8_t> EZLog::sinkFormats[5] = {{1u << (int)LogFormat::TEXT}, {1u << (int)LogFormat::TEXT},
+                                              {1u << (int)LogFormat::TEXT}, {1u << (int)LogFormat::TEXT},
+                                              {1u << (int)LogFormat::TEXT}};
+std::atomic<uint32_t> EZLog::pendingDrops[5] = {};
+std::atomic<bool> EZLog::dropsPending{false};
+EZLog::SinkCheck EZLog::sinkCheck = EZLog::SinkCheck::NONE;
+std::atomic<uint32_t> EZLog::readerGeneration{0};
+std::atomic<uint32_t> EZLog::configEpoch{1};
+std::atomic<uint32_t> EZLog::scopeOverflowCount{0};
+std::atomic<uint32_t> EZLog::rateLimitedCount{0};
+std::atomic<uint32_t> EZLog::repeatedCount{0};
+std::atomic<uint32_t> EZLog::droppedCount[5] = {};
+std::atomic<uint32_t> EZLog::lastLineMillis{0};
 SemaphoreHandle_t EZLog::logSemaphoreMessage = xSemaphoreCreateMutex();
+SemaphoreHandle_t EZLog::logSemaphoreAsync = xSemaphoreCreateMutex();
+TaskHandle_t EZLog::asyncWriterTask = nullptr;
+std::vector<EZLog*> EZLog::asyncInstances;
+SerialSink EZLog::defaultSink(Serial);
+std::vector<LogSink*> EZLog::defaultSinks = {&defaultSink};
@@ -2,10 +2,25 @@
 #define EZ_LOG_H
 
 #include <Arduino.h>
-#include <stack>
 #include <vector>
 #include <string>
+#include <atomic>
 #include "structs.h"
+#include "LogLineBuffer.h"
+#include "LogRingBuffer.h"
+#include "LogBinary.h"
+#include "LogFilter.h"
+#include "LogCallsite.h"
+#include "LogProfiler.h"
+#include "LogHeapTracker.h"
+#include "LogTimestamp.h"
+#include "LogTrace.h"
+#include "LogPrintf.h"
+#include "LogSink.h"
+#include "LogFileSink.h"
+#include "LogCrashRing.h"
+#include "LogRateLimit.h"
+#include "LogMemInfo.h"
 #include "Loggable.h"
 
 
@@ -25,6 +40,25 @@
     #define EZLOG_MAX_LOG_LEVEL       4
 #endif
 
+/**
+ * Index of the FreeRTOS Thread-Local-Storage-Pointer, in which the EZLog-Instance of a task is stored.
+ * Default is the last available pointer, if there is more than one. Pointer 0 belongs to the pthread-keys
+ * (std::thread, thread_local), so with a single pointer (stock Arduino-ESP32) the instance is stored in a pthread-key.
+ */
+#if !defined(EZLOG_TLS_INDEX) && defined(configNUM_THREAD_LOCAL_STORAGE_POINTERS)
+    #if configNUM_THREAD_LOCAL_STORAGE_POINTERS > 1
+        #define EZLOG_TLS_INDEX       (configNUM_THREAD_LOCAL_STORAGE_POINTERS - 1)
+    #endif
+#endif
+
+/**
+ * Maximum nesting depth of EZ_LOG()-Scopes per task (each one needs 40 bytes).
+ * Deeper scopes are not tracked (they log with the prefix of the last tracked scope) and counted in scopeOverflows().
+ */
+#ifndef EZLOG_MAX_SCOPE_DEPTH
+    #define EZLOG_MAX_SCOPE_DEPTH     32
+#endif
+
 
 class EZLog {
 public:
@@ -43,26 +77,69 @@ public:
 
 private:
     /** Singleton Werte (für alle Instanzen): */
-    static LoggingConfig config;
+    static LoggingConfig defaultConfig;              // before init()
+    static std::atomic<const LoggingConfig*> config; // immutable, replaced as a whole by updateConfig()
     static int lastMemoryUsageHeap;
     static int lastMemoryUsagePSRam;
     static int lastTaskID;
-    static SemaphoreHandle_t logSemaphoreStartStop;
+    static std::atomic<EZLog*> retiredInstances;
+    static std::atomic<const LogFilter*> filter;
+    static std::atomic<uint32_t> readers[2];         // tasks in a ReadSection, per generation (see _waitForReaders())
+    static std::atomic<uint32_t> readerGeneration;
+    static std::atomic<uint32_t> configEpoch;
+    static std::atomic<uint32_t> scopeOverflowCount;
+    static std::atomic<uint32_t> rateLimitedCount;
+    static std::atomic<uint32_t> repeatedCount;
+    static std::atomic<uint32_t> droppedCount[5];
+    static std::atomic<uint8_t> sinkFormats[5];      // per loglevel, see _sinkFormats()
+    static std::atomic<uint32_t> pendingDrops[5];    // dropped lines, not yet counted at the sinks (_dropLine())
+    static std::atomic<bool> dropsPending;
+    enum class SinkCheck : uint8_t { NONE, WRITABLE, TIMED_OUT };
+    static SinkCheck sinkCheck;                      // set by _commit() for _waitForSink(), under the output lock
+    static std::atomic<uint32_t> lastLineMillis;    // TimestampFormat::DELTA
     static SemaphoreHandle_t logSemaphoreMessage;
+    static SemaphoreHandle_t logSemaphoreAsync;
+    static TaskHandle_t asyncWriterTask;
+    static std::vector<EZLog*> asyncInstances;
+    static SerialSink defaultSink;
+    static std::vector<LogSink*> defaultSinks;
 
 private:;
     int taskID = 0;
     int depth = 0;
     bool newLineStarted = true;
-    std::stack<String> classStack;
-    std::stack<String> methodStack;
-    std::stack<unsigned long> startTimeStack;
-    String lastPrefix = "";
-    String multilineBuffer = "";
+    struct ScopeFrame {
+        int64_t startMicros;        // behind _start() (timed)
+        const LogCallsite* callsite;
+        uint32_t childMicros;       // durations of the direct child scopes (self time)
+        uint32_t overheadMicros;    // time spent in _start()/_end() of nested scopes
+        uint32_t nestedScopes;      // ... and their number (for the calibrated timer overhead)
+        uint32_t heapFree;          // at the begin (LoggingConfig::heapTracking)
+        uint32_t psramFree;
+        bool logged;                // START-Message was written (and depth increased)
+        bool profiled;              // LoggingConfig::profiling
+        bool heapTracked;           // heapFree/psramFree are set
+        bool timed;                 // startMicros is set: logged, profiled or inside a timed scope
+    };
+    ScopeFrame scopeStack[EZLOG_MAX_SCOPE_DEPTH];
+    uint16_t scopeDepth = 0;
+    uint16_t scopeOverflowDepth = 0;    // untracked scopes above scopeStack
+    const LogCallsite* currentCallsite = nullptr;
+    LogLineBuffer multilineBuffer;
+    LogLineBuffer lineBuffer;
+    LogLineBuffer formatBuffer;         // texts of _logf() (the one of a nested call behind the outer one)
+    LogTimestamp timestamp;
+    LogRingBuffer* ringBuffer = nullptr;
+    uint32_t lastDuration = 0;          // µs, of the scope, whose END-line is written
+    uint32_t lastSelfTime = 0;
     Loglevel lastloglevel = Loglevel::ERROR;
+    bool bypassLimits = false;          // notices of LogRateLimit are written without rate limit / repeat check
+    EZLog* nextRetired = nullptr;
 
 private:
     static EZLog* getInstanceForCurrentTask();
+    static EZLog* _createInstance();
+    static void _retireInstance(EZLog* instance);
 
 public:
     // Init:
@@ -71,60 +148,205 @@ public:
 
 
     static bool start(const String& cls, const String& method);
+    static bool start(const LogCallsite* callsite);
     static void end();
 
+    // All methods are also available for const char*, so String-Literals don't need a String-Object:
     static void error(const String& msg);
-    static void errorln(const String& msg = "");
+    static void error(const char* msg);
+    static void errorln(const String& msg);
+    static void errorln(const char* msg = "");
 
     static void warn(const String& msg);
-    static void warnln(const String& msg = "");
+    static void warn(const char* msg);
+    static void warnln(const String& msg);
+    static void warnln(const char* msg = "");
 
     static void info(const String& msg);
-    static void infoln(const String& msg = "");
+    static void info(const char* msg);
+    static void infoln(const String& msg);
+    static void infoln(const char* msg = "");
 
     static void debug(const String& msg);
-    static void debugln(const String& msg = "");
+    static void debug(const char* msg);
+    static void debugln(const String& msg);
+    static void debugln(const char* msg = "");
 
     static void verbose(const String& msg);
-    static void verboseln(const String& msg = "");
+    static void verbose(const char* msg);
+    static void verboseln(const String& msg);
+    static void verboseln(const char* msg = "");
+
+    // printf-Style (checked by the compiler), rendered without heap allocation (see LogPrintf.h):
+    static void errorf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+    static void errorlnf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+    static void warnf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+    static void warnlnf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+    static void infof(const char* format, ...) __attribute__((format(printf, 1, 2)));
+    static void infolnf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+    static void debugf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+    static void debuglnf(const char* format, ...) __attribute__((format(printf, 1, 2)));
+    static void verbosef(const char* format, ...) __attribute__((format(printf, 1, 2)));
+    static void verboselnf(const char* format, ...) __attribute__((format(printf, 1, 2)));
 
     static void freeMem(const String& prefix = "", bool inBytes = false);
 
+    /**
+     * Prints data as hex + ASCII, 16 bytes per line: "0010  48 65 6c 6c 6f 00 ...  |Hello.|"
+     */
+    static void hexdump(Loglevel loglevel, const void* data, size_t len);
+
+    /**
+     * Returns true, if a message with this loglevel would be printed (or passed to a custom...Action) in the
+     * current scope. Used by the lazy macros EZ_DEBUGLN() etc.
+     */
+    static bool isEnabled(Loglevel loglevel);
+
+    // Async mode:
+    static void flush();
+    static uint32_t asyncDroppedLines();
+
+    // Lines of a loglevel, which were lost for at least one sink (output stalled, see LoggingConfig::backpressurePolicy):
+    static uint32_t droppedLines(Loglevel loglevel);
+
+    static uint32_t scopeOverflows();
+
+    // Rate limit / repeat suppression (LoggingConfig::rateLimit, LoggingConfig::suppressRepeats):
+    static uint32_t rateLimitedLines();
+    static uint32_t repeatedLines();
+
+    // Profiling (LoggingConfig::profiling):
+    static void profileReport(bool histogram = false);
+    static void profileReset();
+
+    // Heap tracking (LoggingConfig::heapTracking):
+    static void heapReport(Print& out = Serial);
+    static void heapReset();
+
+    // Tracing (LoggingConfig::tracing):
+    static void traceDump(Print& out = Serial);
+    static void traceClear();
+
+    // Crash ring (LoggingConfig::crashRing):
+    static void crashDump(Print& out = Serial);
+
 
 private:
-    bool _start(const String& cls, const String& method);
+    bool _start(const LogCallsite* callsite);
     void _end();
+    void _pushScope(const LogCallsite* callsite, bool logged, bool timed);
+    void _endLogged(const ScopeFrame& frame);
+    static uint32_t _scopeDuration(const ScopeFrame& frame, int64_t endMicros);
+    void _recordHeap(const ScopeFrame& frame);
+
+    /**
+     * msg doesn't need to be null-terminated. newline = true appends a '\n' (for the ...ln()-Methods),
+     * without building a new String.
+     */
+    void _msg(Loglevel loglevel, const char* msg, size_t len, boolean newline = false,
+              boolean isStart = false, boolean isEnd = false);
 
-    void _msg(Loglevel loglevel, String msg, boolean isStart = false, boolean isEnd = false);
+    void _error(const char* msg, size_t len);
+    void _errorln(const char* msg, size_t len);
 
-    void _errorln(const String& msg = "");
+    void _warn(const char* msg, size_t len);
+    void _warnln(const char* msg, size_t len);
 
-    void _warn(const String& msg);
-    void _warnln(const String& msg = "");
+    void _info(const char* msg, size_t len);
+    void _infoln(const char* msg, size_t len);
 
-    void _info(const String& msg);
-    void _infoln(const String& msg = "");
+    void _debug(const char* msg, size_t len);
+    void _debugln(const char* msg, size_t len);
 
-    void _debug(const String& msg);
-    void _debugln(const String& msg = "");
+    void _verbose(const char* msg, size_t len);
+    void _verboseln(const char* msg, size_t len);
 
-    void _verbose(const String& msg);
-    void _verboseln(const String& msg = "");
+    static void _logf(Loglevel loglevel, bool newline, const char* format, va_list args);
 
     static void _freeMem(const String& prefix, bool inBytes = false);
     static void _freeMem();
+    void _hexdump(Loglevel loglevel, const uint8_t* data, size_t len);
 
-    String _colorPrefix(String prefix, boolean isStart = false, boolean isEnd = false);
-    void _addFreeMemToMessage();
+    bool _suppressed(Loglevel loglevel, const char* msg, size_t len, bool isStartEnd);
+    void _flushRepeats(const LogCallsite* callsite);
+    void _writeNotice(const LogCallsite* callsite, Loglevel loglevel, const char* text);
+    static uint16_t _rateLimit(const LogCallsite* callsite);
 
-    String getBGColor() const;
-    String ansiColorReset();
+    bool _msgBinary(Loglevel loglevel, const char* msg, size_t len, boolean isStart, boolean isEnd,
+                    const LogMemSample* memInfo);
 
-    static bool _shouldLog(const String& prefix, Loglevel requestedLoglevel);
+    bool _commitLine(Loglevel loglevel);
+    bool _commit(const char* data, size_t len, Loglevel loglevel, LogFormat format);
+    void _output(const char* data, size_t len, Loglevel loglevel, LogFormat format, bool passThrough = false);
+    void _pushAsync(const char* data, size_t len, Loglevel loglevel, uint8_t tag);
+
+    /** Sinks: */
+    /**
+     * Print, which writes complete lines to all sinks (f.e. for LogCrashRing::dump())
+     */
+    class SinkPrint : public Print {
+    public:
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t* buffer, size_t size) override;
+        using Print::write;
+
+    private:
+        LogLineBuffer line;
+    };
+
+    static const std::vector<LogSink*>& _sinks();
+    static uint8_t _sinkFormats(Loglevel loglevel);
+    static void _updateSinkFormats();
+    static void _writeToSinks(const char* data, size_t len, Loglevel loglevel, LogFormat format, bool passThrough);
+    static bool _writeToSink(LogSink* sink, const char* data, size_t len, Loglevel loglevel);
+    static bool _sinksWritable(const char* data, size_t len, Loglevel loglevel, LogFormat format);
+    static bool _waitForSink(LogSink* sink, size_t len, Loglevel loglevel);
+    static void _dropLine(Loglevel loglevel);
+    static void _countPendingDrops();
+    static void _writeError(const char* text);
+
+    static void _startAsyncWriter();
+    static void _asyncWriterTask(void* parameter);
+    static void _drainAsyncBuffers();
+    static void _writeAsyncBuffers();
+
+    void _writeColorPrefix(boolean isStart = false, boolean isEnd = false);
+    void _writeFreeMem(const LogMemSample* sample, const LogMemSample* previous);
+
+    const String& getBGColor() const;
+    void _writeColorReset();
+
+    /**
+     * Lock-free access to config and filter: whatever a task loads inside of a ReadSection, is not deleted by
+     * updateConfig() before the task has left it. Never blocks, can be nested.
+     */
+    class ReadSection {
+    public:
+        ReadSection() : generation(readerGeneration.load() & 1) { readers[generation].fetch_add(1); }
+        ~ReadSection() { readers[generation].fetch_sub(1, std::memory_order_release); }
+
+    private:
+        const uint32_t generation;
+    };
+
+    /**
+     * The current config. Only inside of a ReadSection or under logSemaphoreMessage (see _applyConfig()).
+     */
+    static const LoggingConfig& _config() { return *config.load(); }
+
+    static void _allocateBuffers(const LoggingConfig& newConfig);
+    static const LoggingConfig* _applyConfig(const LoggingConfig& newConfig);
+    static void _dumpCrashRing();
+    static const LogFilter* _compileFilter();
+    static void _waitForReaders();
+    static bool _findFilter(const char* prefix, Loglevel& loglevel, uint16_t* rateLimit = nullptr);
+    static bool _shouldLog(const char* prefix, Loglevel requestedLoglevel);
+    static bool _shouldLog(const LogCallsite* callsite, Loglevel requestedLoglevel);
     bool _shouldLog(Loglevel loglevel) const;
 
     /** Timestamp-Prefix: */
-    String ts();
+    void _writeTimestamp();
+    void _writeDuration(uint32_t micros);
 
 
     /** String-Tools: */
@@ -164,4 +386,51 @@ public:
 #define Log     EZLog
 
 
+/**
+ * Lazy Logging-Macros: the message is only evaluated, if it will be printed. So in
+ *    EZ_DEBUGLN("This is run #" + String(cnt));
+ * no String is built, if DEBUG is filtered out for the current scope (or removed by EZLOG_MAX_LOG_LEVEL).
+ */
+#ifndef EZLOG_DISABLE_COMPLETELY
+    #define EZ_LOG_LAZY(loglevel, method, msg)   do { if (EZLog::isEnabled(loglevel)) EZLog::method(msg); } while (0)
+#else
+    #define EZ_LOG_LAZY(loglevel, method, msg)   do { } while (0)
+#endif
+
+#define EZ_ERROR(msg)           EZ_LOG_LAZY(Loglevel::ERROR, error, msg)
+#define EZ_ERRORLN(msg)         EZ_LOG_LAZY(Loglevel::ERROR, errorln, msg)
+
+#if EZLOG_MAX_LOG_LEVEL >= 1
+    #define EZ_WARN(msg)        EZ_LOG_LAZY(Loglevel::WARN, warn, msg)
+    #define EZ_WARNLN(msg)      EZ_LOG_LAZY(Loglevel::WARN, warnln, msg)
+#else
+    #define EZ_WARN(msg)        do { } while (0)
+    #define EZ_WARNLN(msg)      do { } while (0)
+#endif
+
+#if EZLOG_MAX_LOG_LEVEL >= 2
+    #define EZ_INFO(msg)        EZ_LOG_LAZY(Loglevel::INFO, info, msg)
+    #define EZ_INFOLN(msg)      EZ_LOG_LAZY(Loglevel::INFO, infoln, msg)
+#else
+    #define EZ_INFO(msg)        do { } while (0)
+    #define EZ_INFOLN(msg)      do { } while (0)
+#endif
+
+#if EZLOG_MAX_LOG_LEVEL >= 3
+    #define EZ_DEBUG(msg)       EZ_LOG_LAZY(Loglevel::DEBUG, debug, msg)
+    #define EZ_DEBUGLN(msg)     EZ_LOG_LAZY(Loglevel::DEBUG, debugln, msg)
+#else
+    #define EZ_DEBUG(msg)       do { } while (0)
+    #define EZ_DEBUGLN(msg)     do { } while (0)
+#endif
+
+#if EZLOG_MAX_LOG_LEVEL >= 4
+    #define EZ_VERBOSE(msg)     EZ_LOG_LAZY(Loglevel::VERBOSE, verbose, msg)
+    #define EZ_VERBOSELN(msg)   EZ_LOG_LAZY(Loglevel::VERBOSE, verboseln, msg)
+#else
+    #define EZ_VERBOSE(msg)     do { } while (0)
+    #define EZ_VERBOSELN(msg)   do { } while (0)
+#endif
+
+
 #endif  // EZ_LOG_H
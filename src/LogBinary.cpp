@@ -0,0 +1,137 @@
+#include "LogBinary.h"
+
+std::atomic<const char*> LogBinary::callsiteNames[EZLOG_BINARY_MAX_CALLSITES];
+
+uint16_t LogBinary::callsiteId(const char* name, const size_t len) {
+    const uint32_t h = hash(name, len);
+
+    // Open addressing, the slot index is the ID. The hash only picks the first slot, the slots are compared by
+    // the name pointer, so two callsites with the same hash get different IDs:
+    for (size_t i = 0; i < EZLOG_BINARY_MAX_CALLSITES; i++) {
+        const size_t slot = (h + i) % EZLOG_BINARY_MAX_CALLSITES;
+        const char* current = callsiteNames[slot].load(std::memory_order_acquire);
+        if (current == nullptr && callsiteNames[slot].compare_exchange_strong(current, name,
+                                                                              std::memory_order_acq_rel)) {
+            return static_cast<uint16_t>(slot + 1);
+        }
+        if (current == name) return static_cast<uint16_t>(slot + 1);
+    }
+    return 0;
+}
+
+size_t LogBinary::encodeCallsite(uint8_t* dest, const size_t maxLen, const uint16_t id, const char* name,
+                                 size_t nameLen) {
+    if (maxLen < MAX_HEADER_SIZE + 3) return 0;
+    uint8_t* payload = dest + MAX_HEADER_SIZE;
+    size_t pos = writeVarint(payload, id);
+
+    if (nameLen > maxLen - MAX_HEADER_SIZE - pos) nameLen = maxLen - MAX_HEADER_SIZE - pos;
+    memcpy(payload + pos, name, nameLen);
+    pos += nameLen;
+
+    return finishRecord(dest, TYPE_CALLSITE, pos);
+}
+
+const char* LogBinary::callsiteName(const uint16_t id) {
+    if (id == 0 || id > EZLOG_BINARY_MAX_CALLSITES) return nullptr;
+    return callsiteNames[id - 1].load(std::memory_order_acquire);
+}
+
+uint16_t LogBinary::lineCallsiteId(const char* record, const size_t len) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(record);
+    if (len < 4 || bytes[0] != SYNC || bytes[1] != TYPE_LINE) return 0;
+
+    uint32_t payloadLen = 0;
+    const size_t lengthLen = readVarint(bytes + 2, len - 2, payloadLen);
+    uint32_t id = 0;
+    if (lengthLen == 0 || readVarint(bytes + 2 + lengthLen, len - 2 - lengthLen, id) == 0) return 0;
+    return id <= EZLOG_BINARY_MAX_CALLSITES && callsiteName(static_cast<uint16_t>(id)) != nullptr
+               ? static_cast<uint16_t>(id)
+               : 0;
+}
+
+size_t LogBinary::encodeLine(uint8_t* dest, const size_t maxLen, const LogBinaryLine& line,
+                             const char* msg1, size_t len1, const char* msg2, size_t len2) {
+    if (maxLen < MAX_HEADER_SIZE + 48) return 0;
+    uint8_t* payload = dest + MAX_HEADER_SIZE;
+    size_t pos = writeVarint(payload, line.callsiteId);
+    pos += writeVarint(payload + pos, line.timestamp);
+    payload[pos++] = line.taskID;
+    payload[pos++] = line.depth;
+
+    uint8_t flags = static_cast<uint8_t>(line.loglevel) & 0x07;
+    if (line.isStart) flags |= FLAG_START;
+    if (line.isEnd) flags |= FLAG_END | FLAG_MICROS;
+    if (line.hasMemInfo) flags |= FLAG_MEMINFO;
+    if (len1 > 0) flags |= FLAG_PARTIAL;
+    payload[pos++] = flags;
+
+    if (line.isEnd) {
+        pos += writeVarint(payload + pos, line.duration);
+        pos += writeVarint(payload + pos, line.hasSelfTime ? std::min<uint32_t>(line.selfTime, UINT32_MAX - 1) + 1 : 0);
+    }
+    if (line.hasMemInfo) {
+        pos += writeVarint(payload + pos, line.heapFree);
+        pos += writeVarint(payload + pos, line.heapLargestBlock);
+        pos += writeVarint(payload + pos, line.psramFree);
+    }
+
+    // Message (truncated, if necessary). 5 bytes are reserved for the length of the buffered text:
+    size_t space = maxLen - MAX_HEADER_SIZE - pos - 5;
+    if (len1 > space) len1 = space;
+    if (len1 > 0) pos += writeVarint(payload + pos, static_cast<uint32_t>(len1));
+    memcpy(payload + pos, msg1, len1);
+    pos += len1;
+    space = maxLen - MAX_HEADER_SIZE - pos;
+    if (msg2 != nullptr) {
+        if (len2 > space) len2 = space;
+        memcpy(payload + pos, msg2, len2);
+        pos += len2;
+    }
+
+    return finishRecord(dest, TYPE_LINE, pos);
+}
+
+/**
+ * The payload has been written at dest + MAX_HEADER_SIZE. Writes the header and moves the payload directly behind it.
+ */
+size_t LogBinary::finishRecord(uint8_t* dest, const uint8_t type, const size_t payloadLen) {
+    uint8_t header[MAX_HEADER_SIZE];
+    header[0] = SYNC;
+    header[1] = type;
+    const size_t headerLen = 2 + writeVarint(header + 2, static_cast<uint32_t>(payloadLen));
+
+    memmove(dest + headerLen, dest + MAX_HEADER_SIZE, payloadLen);
+    memcpy(dest, header, headerLen);
+    return headerLen + payloadLen;
+}
+
+size_t LogBinary::writeVarint(uint8_t* dest, uint32_t value) {
+    size_t len = 0;
+    while (value >= 0x80) {
+        dest[len++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    dest[len++] = static_cast<uint8_t>(value);
+    return len;
+}
+
+/** Returns the number of bytes read, 0 if the varint is incomplete or too long */
+size_t LogBinary::readVarint(const uint8_t* src, const size_t len, uint32_t& value) {
+    value = 0;
+    for (size_t i = 0; i < len && i < 5; i++) {
+        value |= static_cast<uint32_t>(src[i] & 0x7F) << (7 * i);
+        if ((src[i] & 0x80) == 0) return i + 1;
+    }
+    return 0;
+}
+
+/** FNV-1a, 0 is reserved for "empty slot" */
+uint32_t LogBinary::hash(const char* data, const size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= static_cast<uint8_t>(data[i]);
+        h *= 16777619u;
+    }
+    return h == 0 ? 1 : h;
+}
@@ -0,0 +1,107 @@
+#ifndef EZ_LOG_BINARY_H
+#define EZ_LOG_BINARY_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "structs.h"
+
+
+/**
+ * Maximum number of different callsites (Class::method), which get a short ID in binary mode.
+ * If the table is full, the name is sent again before each line (ID 0).
+ */
+#ifndef EZLOG_BINARY_MAX_CALLSITES
+    #define EZLOG_BINARY_MAX_CALLSITES    256
+#endif
+
+
+/**
+ * Data of one binary Log-Line (everything, the host-decoder needs to rebuild the colored output)
+ */
+struct LogBinaryLine {
+    uint16_t callsiteId = 0;
+    uint32_t timestamp = 0;     // millis()
+    uint8_t taskID = 0;
+    uint8_t depth = 0;
+    Loglevel loglevel = Loglevel::DEBUG;
+    bool isStart = false;
+    bool isEnd = false;
+    uint32_t duration = 0;      // µs, only for isEnd
+    bool hasSelfTime = false;   // LoggingConfig::printSelfTime
+    uint32_t selfTime = 0;      // µs
+    bool hasMemInfo = false;
+    uint32_t heapFree = 0;      // kB
+    uint32_t heapLargestBlock = 0;  // kB
+    uint32_t psramFree = 0;     // kB
+};
+
+
+/**
+ * Binary Log-Format (LoggingConfig::outputFormat = LogFormat::BINARY).
+ *
+ * The device only sends compact records, the colored text is rebuilt on the host by tools/ezlog_decode.py.
+ * Every record:   SYNC (0xE7) | type (1 byte) | payload-length (varint) | payload
+ *
+ *   CALLSITE (0x01):  id (varint) | name ("Class::method")
+ *   LINE (0x02):      id (varint) | timestamp ms (varint) | taskID (u8) | depth (u8) | flags (u8)
+ *                     [duration (varint), if END] [self time + 1 (varint, 0 = none), if MICROS] [heap, largest block, psram in kB (3x varint), if MEMINFO]
+ *                     [length of the buffered Log::debug()-text at the beginning of the message (varint), if PARTIAL]
+ *                     | message bytes (without the trailing newline)
+ *
+ *   flags:  bit 0-2 = Loglevel, 0x08 = START, 0x10 = END, 0x20 = MEMINFO, 0x40 = PARTIAL,
+ *           0x80 = MICROS (duration in µs, followed by the self time - older streams send the duration in ms)
+ *
+ * All bytes outside of records (boot messages, esp_backtrace_print, ...) are passed through by the decoder.
+ */
+class LogBinary {
+public:
+    static constexpr uint8_t SYNC = 0xE7;
+    static constexpr uint8_t TYPE_CALLSITE = 0x01;
+    static constexpr uint8_t TYPE_LINE = 0x02;
+
+    static constexpr uint8_t FLAG_START = 0x08;
+    static constexpr uint8_t FLAG_END = 0x10;
+    static constexpr uint8_t FLAG_MEMINFO = 0x20;
+    static constexpr uint8_t FLAG_PARTIAL = 0x40;
+    static constexpr uint8_t FLAG_MICROS = 0x80;
+
+    /** Maximum size of a record header (sync, type, length-varint) */
+    static constexpr size_t MAX_HEADER_SIZE = 2 + 5;
+
+    /**
+     * Returns the ID (1..EZLOG_BINARY_MAX_CALLSITES) of a callsite, 0 if the table is full.
+     * name is the interned name of the LogCallsite, it's compared by pointer. Lock-free, IDs are never reused.
+     */
+    static uint16_t callsiteId(const char* name, size_t len);
+
+    static size_t encodeCallsite(uint8_t* dest, size_t maxLen, uint16_t id, const char* name, size_t nameLen);
+
+    /**
+     * Name of an ID from callsiteId(), nullptr if it's unknown
+     */
+    static const char* callsiteName(uint16_t id);
+
+    /**
+     * ID of the callsite of a LINE record, 0 for anything else (other records, text, a callsite without ID).
+     * callsiteName() of a returned ID is never nullptr.
+     */
+    static uint16_t lineCallsiteId(const char* record, size_t len);
+
+    /**
+     * Encodes a line. The message can consist of two parts (buffered text of Log::debug() + actual message),
+     * which are colored differently by the decoder. Too long messages are truncated.
+     */
+    static size_t encodeLine(uint8_t* dest, size_t maxLen, const LogBinaryLine& line,
+                             const char* msg1, size_t len1, const char* msg2 = nullptr, size_t len2 = 0);
+
+private:
+    static size_t writeVarint(uint8_t* dest, uint32_t value);
+    static size_t readVarint(const uint8_t* src, size_t len, uint32_t& value);
+    static size_t finishRecord(uint8_t* dest, uint8_t type, size_t payloadLen);
+    static uint32_t hash(const char* data, size_t len);
+
+    static std::atomic<const char*> callsiteNames[EZLOG_BINARY_MAX_CALLSITES];
+};
+
+
+#endif // EZ_LOG_BINARY_H
@@ -0,0 +1,89 @@
+#include "LogCallsite.h"
+#include <mutex>
+#include <vector>
+
+namespace {
+    std::mutex registryMutex;
+    LogCallsite* callsites = nullptr;
+    std::vector<const char*> internedStrings;
+
+    const char* _intern(const char* str, const size_t len) {
+        for (const char* interned : internedStrings) {
+            if (strncmp(interned, str, len) == 0 && interned[len] == '\0') return interned;
+        }
+        char* copy = new char[len + 1];
+        memcpy(copy, str, len);
+        copy[len] = '\0';
+        internedStrings.push_back(copy);
+        return copy;
+    }
+}
+
+LogClassName LogClassName::fromFileRuntime(const char* path) {
+    size_t start = 0, dot = 0, len = 0;
+    for (; path[len] != '\0'; len++) {
+        if (path[len] == '/' || path[len] == '\\') start = len + 1;
+        else if (path[len] == '.') dot = len + 1;
+    }
+    return make(path, start, dot, len);
+}
+
+const char* LogCallsite::intern(const char* str, const size_t len) {
+    std::lock_guard<std::mutex> guard(registryMutex);
+    return _intern(str, len);
+}
+
+const LogCallsite* LogCallsite::first() {
+    std::lock_guard<std::mutex> guard(registryMutex);
+    return callsites;
+}
+
+/**
+ * Only called once per macro (and for each new class at EZ_LOG_CLASS()), so the lock and the linear search don't matter.
+ */
+const LogCallsite* LogCallsite::get(const char* cls, const size_t clsLen, const char* method, const size_t methodLen) {
+    std::lock_guard<std::mutex> guard(registryMutex);
+
+    for (const LogCallsite* callsite = callsites; callsite != nullptr; callsite = callsite->next) {
+        if (callsite->clsLen == clsLen && callsite->methodLen == methodLen &&
+            strncmp(callsite->cls, cls, clsLen) == 0 && strncmp(callsite->method, method, methodLen) == 0) {
+            return callsite;
+        }
+    }
+
+    // name = "Class::method"
+    char* name = new char[clsLen + 2 + methodLen + 1];
+    memcpy(name, cls, clsLen);
+    memcpy(name + clsLen, "::", 2);
+    memcpy(name + clsLen + 2, method, methodLen);
+    name[clsLen + 2 + methodLen] = '\0';
+
+    auto* callsite = new LogCallsite();
+    callsite->name = name;
+    callsite->nameLen = clsLen + 2 + methodLen;
+    callsite->cls = _intern(cls, clsLen);
+    callsite->clsLen = clsLen;
+    callsite->method = name + clsLen + 2;
+    callsite->methodLen = methodLen;
+    callsite->next = callsites;
+    callsites = callsite;
+    return callsite;
+}
+
+const LogCallsite* LogCallsite::get(const String& cls, const String& method) {
+    return get(cls.c_str(), cls.length(), method.c_str(), method.length());
+}
+
+const LogCallsite* LogCallsite::get(const LogClassName cls, const char* method) {
+    return get(cls.str, cls.len, method, strlen(method));
+}
+
+const LogCallsite* LogCallsite::get(std::atomic<const LogCallsite*>& cache, const char* internedCls,
+                                    const char* method) {
+    const LogCallsite* cached = cache.load(std::memory_order_acquire);
+    if (cached != nullptr && cached->cls == internedCls) return cached;
+
+    const LogCallsite* callsite = get(internedCls, strlen(internedCls), method, strlen(method));
+    cache.store(callsite, std::memory_order_release);
+    return callsite;
+}
@@ -0,0 +1,132 @@
+#ifndef EZ_LOG_CALLSITE_H
+#define EZ_LOG_CALLSITE_H
+
+#include <Arduino.h>
+#include <atomic>
+
+
+/**
+ * Class name, extracted from a file name (like __FILE__) at compile time:
+ *    "/path/to/MyClass.cpp" -> "MyClass"
+ * Points into the string literal, so it's not null-terminated.
+ */
+struct LogClassName {
+    const char* str;
+    size_t len;
+
+    static constexpr LogClassName fromFile(const char* path) {
+        return make(path, max(lastIndex(path, '/', 0, 0), lastIndex(path, '\\', 0, 0)), lastIndex(path, '.', 0, 0),
+                    length(path, 0));
+    }
+
+    /** Same as fromFile(), but without recursion - for strings at runtime (like Loggable::fileName()) */
+    static LogClassName fromFileRuntime(const char* path);
+
+    /**
+     * EZ_LOG() / EZ_LOG_STATIC(): a string literal (like __FILE__) is extracted by the compiler (the static in the
+     * macro is constant-initialized), any other file name (const char*, String) at runtime.
+     */
+    template <size_t N>
+    static constexpr LogClassName of(const char (&path)[N]) { return fromFile(path); }
+
+    /** The name is interned (see LogCallsite::intern()), so it stays valid after path is gone */
+    template <typename T>
+    static LogClassName of(const T& path);
+
+private:
+    static const char* cStr(const char* s) { return s; }
+    static const char* cStr(const String& s) { return s.c_str(); }
+
+    // C++11-constexpr: only recursion, no loops. Positions are index + 1, 0 = not found.
+    static constexpr size_t length(const char* s, const size_t i) {
+        return s[i] == '\0' ? i : length(s, i + 1);
+    }
+
+    static constexpr size_t lastIndex(const char* s, const char c, const size_t i, const size_t found) {
+        return s[i] == '\0' ? found : lastIndex(s, c, i + 1, s[i] == c ? i + 1 : found);
+    }
+
+    static constexpr size_t max(const size_t a, const size_t b) { return a > b ? a : b; }
+
+    // Removes the path and the extension (only if the last dot is behind the first char of the name):
+    static constexpr LogClassName make(const char* path, const size_t start, const size_t dot, const size_t len) {
+        return LogClassName{path + start, (dot > start + 1 ? dot - 1 : len) - start};
+    }
+};
+
+
+/**
+ * Static descriptor of a "Class::method", which is logged by EZ_LOG() / EZ_LOG_CLASS() / EZ_LOG_STATIC().
+ *
+ * Each macro keeps a pointer to its descriptor in a function-local static, so the name is built only once.
+ * Descriptors are interned (one per name) and never freed.
+ */
+struct LogCallsite {
+    const char* name;       // "Class::method"
+    size_t nameLen;
+    const char* cls;        // interned (see intern()), so it can be compared by pointer
+    size_t clsLen;
+    const char* method;     // points into name
+    size_t methodLen;
+
+    /**
+     * Cached filter decision: (config-epoch << 8) | enabled-mask (bit n = Loglevel n).
+     * Is recalculated, when the epoch differs (updateConfig() was called), see EZLog::_shouldLog(const LogCallsite*, ...).
+     */
+    mutable std::atomic<uint32_t> filterState{0};
+
+    /** ID in the callsite-table of the binary format, -1 = not yet assigned */
+    mutable std::atomic<int32_t> binaryId{-1};
+
+    /** Index in the table of the profiler, -1 = not yet assigned, -2 = table full */
+    mutable std::atomic<int32_t> profileSlot{-1};
+
+    /** Index in the table of the heap tracker, -1 = not yet assigned, -2 = table full */
+    mutable std::atomic<int32_t> heapSlot{-1};
+
+    /** Rate limit in lines per second (0 = none), cached together with filterState */
+    mutable std::atomic<uint16_t> rateLimit{0};
+
+    /** State of LogRateLimit: token bucket, dropped lines and the last message (repeat suppression) */
+    mutable std::atomic<uint64_t> rateBucket{0};
+    mutable std::atomic<uint32_t> rateDropped{0};
+    mutable std::atomic<uint32_t> lastMessageHash{0};
+    mutable std::atomic<uint32_t> repeatCount{0};
+    mutable std::atomic<uint8_t> repeatLoglevel{0};
+
+    LogCallsite* next = nullptr;
+
+    /**
+     * Returns the descriptor for cls::method (creates it, if it doesn't exist yet).
+     */
+    static const LogCallsite* get(const char* cls, size_t clsLen, const char* method, size_t methodLen);
+    static const LogCallsite* get(const String& cls, const String& method);
+    static const LogCallsite* get(LogClassName cls, const char* method);
+
+    /**
+     * EZ_LOG_CLASS(): the class name depends on the object (virtual fileName()), so the cache of the macro only holds
+     * the last descriptor and is compared by the pointer of the interned class name.
+     */
+    static const LogCallsite* get(std::atomic<const LogCallsite*>& cache, const char* internedCls, const char* method);
+
+    /**
+     * First descriptor of the registry, the others follow by next. New descriptors are only added in front,
+     * so the list can be walked without lock.
+     */
+    static const LogCallsite* first();
+
+    /**
+     * Returns a pointer to a copy of the string, which is equal for equal strings and never freed.
+     */
+    static const char* intern(const char* str, size_t len);
+};
+
+
+template <typename T>
+LogClassName LogClassName::of(const T& path) {
+    const LogClassName name = fromFileRuntime(cStr(path));
+    return LogClassName{LogCallsite::intern(name.str, name.len), name.len};
+}
+
+
+#endif // EZ_LOG_CALLSITE_H
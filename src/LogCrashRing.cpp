@@ -0,0 +1,159 @@
+#include "LogCrashRing.h"
+#include <esp_system.h>
+
+static_assert(EZLOG_CRASH_RING_RECORD_SIZE >= 32 && EZLOG_CRASH_RING_RECORD_SIZE <= 16 + 252 &&
+              EZLOG_CRASH_RING_RECORD_SIZE % 4 == 0,
+              "EZLOG_CRASH_RING_RECORD_SIZE must be a multiple of 4 between 32 and 268");
+
+namespace {
+    constexpr uint32_t MAGIC = 0x455A4352;     // "EZCR"
+
+    const char* const loglevelNames[] = {"[ERROR]   ", "[WARN]    ", "[INFO]    ", "[DEBUG]   ", "[VERBOSE] "};
+
+    const char* resetReason() {
+        static const char* const names[] = {"UNKNOWN", "POWERON", "EXT", "SW", "PANIC", "INT_WDT", "TASK_WDT",
+                                            "WDT", "DEEPSLEEP", "BROWNOUT", "SDIO"};
+        const unsigned reason = static_cast<unsigned>(esp_reset_reason());
+        return reason < sizeof(names) / sizeof(names[0]) ? names[reason] : "OTHER";
+    }
+}
+
+EZLOG_CRASH_RING_ATTR LogCrashRing::Region LogCrashRing::region;
+std::atomic<uint32_t> LogCrashRing::nextSeq{1};
+uint32_t LogCrashRing::previousBootEnd = 0;
+bool LogCrashRing::started = false;
+
+size_t LogCrashRing::begin() {
+    if (started) return 0;
+
+    if (region.magic != MAGIC || region.records != EZLOG_CRASH_RING_RECORDS ||
+        region.recordSize != EZLOG_CRASH_RING_RECORD_SIZE || region.headerCrc != headerCrc()) {
+        // Power-on (or another layout): the memory contains garbage
+        memset(&region, 0, sizeof(region));
+        region.magic = MAGIC;
+        region.records = EZLOG_CRASH_RING_RECORDS;
+        region.recordSize = EZLOG_CRASH_RING_RECORD_SIZE;
+        region.headerCrc = headerCrc();
+        previousBootEnd = 0;
+        nextSeq.store(1, std::memory_order_relaxed);
+        started = true;
+        return 0;
+    }
+
+    // The records of the previous boot stay readable, until they are overwritten:
+    size_t count = 0;
+    uint32_t lastSeq = 0;
+    for (const Record& record : region.record) {
+        if (!isValid(record)) continue;
+        count++;
+        if (record.seq > lastSeq) lastSeq = record.seq;
+    }
+    previousBootEnd = lastSeq;
+    nextSeq.store(lastSeq + 1, std::memory_order_relaxed);
+    region.bootCount++;
+    region.headerCrc = headerCrc();
+    started = true;
+    return count;
+}
+
+void LogCrashRing::record(const LogCallsite* callsite, const uint8_t taskID, const Loglevel loglevel,
+                          const uint8_t flags, const char* msg1, const size_t len1, const char* msg2,
+                          const size_t len2) {
+    const uint32_t seq = nextSeq.fetch_add(1, std::memory_order_relaxed);
+    Record& record = region.record[seq % EZLOG_CRASH_RING_RECORDS];
+    record.seq = 0;
+    std::atomic_signal_fence(std::memory_order_release);
+
+    // "Class::method: message", truncated:
+    size_t len = 0;
+    const auto append = [&record, &len](const char* str, const size_t n) {
+        const size_t count = std::min(n, sizeof(record.text) - len);
+        memcpy(record.text + len, str, count);
+        len += count;
+    };
+    if (callsite != nullptr) {
+        append(callsite->name, callsite->nameLen);
+        if (len1 + len2 > 0) append(": ", 2);
+    }
+    append(msg1, len1);
+    append(msg2, len2);
+
+    record.timestamp = millis();
+    record.taskID = taskID;
+    record.loglevel = static_cast<uint8_t>(loglevel);
+    record.flags = flags;
+    record.textLen = static_cast<uint8_t>(len);
+    record.crc = recordCrc(record, seq);
+    std::atomic_signal_fence(std::memory_order_release);   // seq is written last
+    record.seq = seq;
+}
+
+void LogCrashRing::dump(Print& out, const bool previousBoot) {
+    if (!started) return;
+
+    // Valid records, sorted by seq:
+    const Record* sorted[EZLOG_CRASH_RING_RECORDS];
+    size_t count = 0;
+    for (const Record& record : region.record) {
+        if (!isValid(record) || (previousBoot && record.seq > previousBootEnd)) continue;
+        size_t pos = count++;
+        while (pos > 0 && sorted[pos - 1]->seq > record.seq) {
+            sorted[pos] = sorted[pos - 1];
+            pos--;
+        }
+        sorted[pos] = &record;
+    }
+    if (count == 0) return;
+
+    char line[EZLOG_CRASH_RING_RECORD_SIZE + 64];
+    if (previousBoot) {
+        snprintf(line, sizeof(line), "---- EZLog: last %u lines before the reset (reason: %s, boot #%u) ----\r\n",
+                 static_cast<unsigned>(count), resetReason(), static_cast<unsigned>(region.bootCount));
+        out.print(line);
+    }
+    for (size_t i = 0; i < count; i++) {
+        const Record& record = *sorted[i];
+        const unsigned long timestamp = record.timestamp;
+        const char* prefix = (record.flags & FLAG_START) ? "++ " : ((record.flags & FLAG_END) ? "-- " : "");
+        const char* suffix = (record.flags & FLAG_START) ? " - [START]" : ((record.flags & FLAG_END) ? " - [END]" : "");
+        snprintf(line, sizeof(line), "[%u] %02lu:%02lu:%02lu.%03lu %s%s%.*s%s\r\n", record.taskID,
+                 timestamp / 3600000, (timestamp % 3600000) / 60000, (timestamp % 60000) / 1000, timestamp % 1000,
+                 loglevelNames[record.loglevel % 5], prefix, static_cast<int>(record.textLen), record.text, suffix);
+        out.print(line);
+    }
+    if (previousBoot) out.print("---- EZLog: end of the previous boot ----\r\n");
+}
+
+bool LogCrashRing::isValid(const Record& record) {
+    return record.seq != 0 && record.textLen <= sizeof(record.text) && record.crc == recordCrc(record, record.seq);
+}
+
+/**
+ * Fletcher-like checksum over the 32-bit words of the record (behind the crc-field). Cheap enough for each line,
+ * a record, which is written during the reset, is already detected by seq = 0.
+ */
+uint32_t LogCrashRing::recordCrc(const Record& record, const uint32_t seq) {
+    uint32_t words[(sizeof(Record) - offsetof(Record, timestamp)) / 4];
+    memcpy(words, &record.timestamp, sizeof(words));
+
+    uint32_t sum1 = seq;
+    uint32_t sum2 = seq;
+    for (const uint32_t word : words) {
+        sum1 += word;
+        sum2 += sum1;
+    }
+    return sum1 ^ ((sum2 << 16) | (sum2 >> 16));
+}
+
+/**
+ * CRC-32 (IEEE) of the header, only calculated in begin()
+ */
+uint32_t LogCrashRing::headerCrc() {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&region);
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < offsetof(Region, headerCrc); i++) {
+        crc ^= bytes[i];
+        for (uint8_t bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
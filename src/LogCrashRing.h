@@ -0,0 +1,106 @@
+#ifndef EZ_LOG_CRASHRING_H
+#define EZ_LOG_CRASHRING_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "structs.h"
+#include "LogCallsite.h"
+
+
+/**
+ * Number and size of the records in the crash ring (LoggingConfig::crashRing). Each record holds
+ * "Class::method: message" with up to (EZLOG_CRASH_RING_RECORD_SIZE - 16) characters.
+ * The default needs 3 kB of the 8 kB RTC slow memory.
+ */
+#ifndef EZLOG_CRASH_RING_RECORDS
+    #define EZLOG_CRASH_RING_RECORDS        32
+#endif
+#ifndef EZLOG_CRASH_RING_RECORD_SIZE
+    #define EZLOG_CRASH_RING_RECORD_SIZE    96
+#endif
+
+/**
+ * Memory section of the crash ring, which is not initialized on a reset (abort(), watchdog, brownout, ...)
+ */
+#ifndef EZLOG_CRASH_RING_ATTR
+    #ifdef RTC_NOINIT_ATTR
+        #define EZLOG_CRASH_RING_ATTR       RTC_NOINIT_ATTR
+    #else
+        #define EZLOG_CRASH_RING_ATTR
+    #endif
+#endif
+
+
+/**
+ * Keeps the last log lines in a no-init RAM section, which survives a reset. After the reset, the lines of
+ * the previous boot are printed by Log::init(), so the last words before an abort() or a watchdog are not lost.
+ *
+ * The memory has a header with magic and CRC (after power-on it contains garbage), each record a checksum and a
+ * sequence number, which is written last (a record, which was interrupted by the reset, is skipped).
+ * Recording is lock-free and needs no more than copying the text and summing up 96 bytes.
+ */
+class LogCrashRing {
+public:
+    static constexpr uint8_t FLAG_START = 0x01;
+    static constexpr uint8_t FLAG_END = 0x02;
+
+    /**
+     * Checks the memory (only once per boot). Returns the number of records of the previous boot.
+     */
+    static size_t begin();
+    static bool isEnabled() { return started; }
+
+    static void record(const LogCallsite* callsite, uint8_t taskID, Loglevel loglevel, uint8_t flags,
+                       const char* msg1, size_t len1, const char* msg2, size_t len2);
+
+    /**
+     * Writes the records of the previous boot (previousBoot = true) or all records as text lines
+     */
+    static void dump(Print& out, bool previousBoot);
+
+#ifndef ESP_PLATFORM
+    /**
+     * Host-Builds: simulates a reset, the ring itself is kept.
+     */
+    static void simulateReset() { started = false; }
+
+    /**
+     * Host-Builds: the raw memory of the ring (header and records), f.e. to simulate its corruption
+     */
+    static uint8_t* memory() { return reinterpret_cast<uint8_t*>(&region); }
+    static size_t memorySize() { return sizeof(region); }
+#endif
+
+private:
+    struct Record {
+        uint32_t seq;       // 0 = empty / being written
+        uint32_t crc;       // checksum of seq and everything behind this field
+        uint32_t timestamp; // millis()
+        uint8_t taskID;
+        uint8_t loglevel;
+        uint8_t flags;
+        uint8_t textLen;
+        char text[EZLOG_CRASH_RING_RECORD_SIZE - 16];
+    };
+
+    struct Region {
+        uint32_t magic;
+        uint16_t records;
+        uint16_t recordSize;
+        uint32_t bootCount;
+        uint32_t headerCrc;
+        Record record[EZLOG_CRASH_RING_RECORDS];
+    };
+
+    static uint32_t recordCrc(const Record& record, uint32_t seq);
+    static uint32_t headerCrc();
+    static bool isValid(const Record& record);
+
+    static Region region;
+    static std::atomic<uint32_t> nextSeq;
+    static uint32_t previousBootEnd;   // last seq of the previous boot
+    static bool started;
+};
+
+
+#endif // EZ_LOG_CRASHRING_H
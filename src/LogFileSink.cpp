@@ -0,0 +1,229 @@
+#include "LogFileSink.h"
+#include "LogBinary.h"
+#include "LogLineBuffer.h"
+
+FileSink::FileSink(fs::FS& _filesystem, const char* _path, const size_t _maxFileSize, const uint8_t _maxFiles,
+                   const Loglevel _loglevel, const LogFormat _format)
+    : LogSink(_loglevel, _format), filesystem(_filesystem), path(_path), maxFileSize(_maxFileSize),
+      maxFiles(_maxFiles > 0 ? _maxFiles : 1) {
+}
+
+FileSink::~FileSink() {
+    close();
+    delete[] buffer;
+}
+
+void FileSink::write(const char* data, size_t len, const Loglevel lineLoglevel) {
+    if (!file) {
+        if (!open()) return;
+        startFile(data, len);
+    }
+
+    if (fileSize + used + len > maxFileSize && fileSize + used > 0) {
+        writeBuffer();
+        rotate();
+        if (!file) return;
+        startFile(data, len);
+    }
+
+    while (len > 0) {
+        const size_t chunk = std::min(len, static_cast<size_t>(EZLOG_FILE_BUFFER_SIZE) - used);
+        memcpy(buffer + used, data, chunk);
+        used += chunk;
+        data += chunk;
+        len -= chunk;
+        if (used == EZLOG_FILE_BUFFER_SIZE) writeBuffer();
+    }
+
+    if (lineLoglevel == Loglevel::ERROR || millis() - lastFlush >= flushIntervalMs) flush();
+}
+
+void FileSink::flush() {
+    if (!file) return;
+    writeBuffer();
+    file.flush();
+    lastFlush = millis();
+}
+
+void FileSink::poll() {
+    if (used > 0 && millis() - lastFlush >= flushIntervalMs) flush();
+}
+
+void FileSink::close() {
+    if (!file) return;
+    flush();
+    file.close();
+}
+
+bool FileSink::open() {
+    // Filesystem not mounted (yet)? Don't try it again for each line:
+    if (openFailed && millis() - lastFlush < flushIntervalMs) return false;
+
+    if (buffer == nullptr) buffer = new char[EZLOG_FILE_BUFFER_SIZE];
+    if (!recoveryDone) {
+        recover();
+        recoveryDone = true;
+    }
+
+    file = filesystem.open(path, FILE_APPEND);
+    lastFlush = millis();
+    openFailed = !file;
+    if (openFailed) return false;
+
+    fileSize = file.size();
+    return true;
+}
+
+/**
+ * Cuts off an incomplete line/record at the end of the file. The complete part is copied into a temporary file,
+ * which replaces the original (there's no truncate() in the Arduino FS-API).
+ */
+void FileSink::recover() {
+    const String tempPath = path + ".tmp";
+    if (!filesystem.exists(path) && filesystem.exists(tempPath)) {
+        filesystem.rename(tempPath, path);     // power loss during the last recovery
+    }
+
+    fs::File current = filesystem.open(path, FILE_READ);
+    if (!current) return;
+
+    const size_t size = current.size();
+    const size_t valid = validLength(current);
+    if (valid == size) {
+        current.close();
+        return;
+    }
+
+    fs::File temp = filesystem.open(tempPath, FILE_WRITE);
+    if (!temp) {
+        current.close();
+        return;
+    }
+    current.seek(0);
+    size_t copied = 0;
+    while (copied < valid) {
+        const size_t chunk = std::min(static_cast<size_t>(EZLOG_FILE_BUFFER_SIZE), valid - copied);
+        const size_t read = current.read(reinterpret_cast<uint8_t*>(buffer), chunk);
+        if (read == 0) break;
+        temp.write(reinterpret_cast<const uint8_t*>(buffer), read);
+        copied += read;
+    }
+    current.close();
+    temp.close();
+
+    filesystem.remove(path);
+    filesystem.rename(tempPath, path);
+    recovered += size - valid;
+}
+
+/**
+ * Length of the file up to the end of the last complete line (text) or record (binary)
+ */
+size_t FileSink::validLength(fs::File& current) {
+    const size_t size = current.size();
+
+    if (format != LogFormat::BINARY) {
+        // Last '\n', searched backwards
+        size_t end = size;
+        while (end > 0) {
+            const size_t chunk = std::min(static_cast<size_t>(EZLOG_FILE_BUFFER_SIZE), end);
+            current.seek(end - chunk);
+            if (current.read(reinterpret_cast<uint8_t*>(buffer), chunk) != chunk) return 0;
+            for (size_t i = chunk; i > 0; i--) {
+                if (buffer[i - 1] == '\n') return end - chunk + i;
+            }
+            end -= chunk;
+        }
+        return 0;
+    }
+
+    // Binary: records (see LogBinary.h) and passed through text lines, parsed from the beginning
+    enum { TEXT, TYPE, LENGTH, PAYLOAD } state = TEXT;
+    uint32_t remaining = 0;
+    uint8_t shift = 0;
+    size_t pos = 0;
+    size_t valid = 0;
+
+    current.seek(0);
+    size_t read;
+    while ((read = current.read(reinterpret_cast<uint8_t*>(buffer), EZLOG_FILE_BUFFER_SIZE)) > 0) {
+        for (size_t i = 0; i < read; i++) {
+            const uint8_t c = static_cast<uint8_t>(buffer[i]);
+            pos++;
+            switch (state) {
+                case TEXT:
+                    if (c == LogBinary::SYNC) state = TYPE;
+                    else if (c == '\n') valid = pos;
+                    break;
+                case TYPE:
+                    state = (c == LogBinary::TYPE_CALLSITE || c == LogBinary::TYPE_LINE) ? LENGTH : TEXT;
+                    remaining = 0;
+                    shift = 0;
+                    break;
+                case LENGTH:
+                    remaining |= static_cast<uint32_t>(c & 0x7F) << shift;
+                    shift += 7;
+                    if (c & 0x80) {
+                        if (shift > 28) state = TEXT;
+                    } else if (remaining == 0 || remaining > EZLOG_MAX_LINE_LENGTH) {
+                        if (remaining == 0) valid = pos;
+                        state = TEXT;
+                    } else {
+                        state = PAYLOAD;
+                    }
+                    break;
+                case PAYLOAD:
+                    if (--remaining == 0) {
+                        valid = pos;
+                        state = TEXT;
+                    }
+                    break;
+            }
+        }
+    }
+    return valid;
+}
+
+void FileSink::writeBuffer() {
+    if (used == 0 || !file) return;
+    file.write(reinterpret_cast<const uint8_t*>(buffer), used);
+    fileSize += used;
+    written += used;
+    writes++;
+    used = 0;
+}
+
+void FileSink::rotate() {
+    file.close();
+    if (maxFiles > 1) {
+        if (filesystem.exists(rotatedPath(maxFiles - 1))) filesystem.remove(rotatedPath(maxFiles - 1));
+        for (uint8_t index = maxFiles - 1; index > 1; index--) {
+            if (filesystem.exists(rotatedPath(index - 1))) filesystem.rename(rotatedPath(index - 1), rotatedPath(index));
+        }
+        filesystem.rename(path, rotatedPath(1));
+    } else {
+        filesystem.remove(path);
+    }
+
+    file = filesystem.open(path, FILE_WRITE);
+    fileSize = 0;
+}
+
+/**
+ * BINARY: each file must be decodable on its own, so the callsite names are sent again. The line, which is written
+ * now, gets its name right here (EZLog checked it for the previous file). The buffer is empty at this point.
+ */
+void FileSink::startFile(const char* data, const size_t len) {
+    resetCallsites();
+    const uint16_t id = format == LogFormat::BINARY ? LogBinary::lineCallsiteId(data, len) : 0;
+    if (id == 0) return;
+
+    const char* name = LogBinary::callsiteName(id);
+    used = LogBinary::encodeCallsite(reinterpret_cast<uint8_t*>(buffer), EZLOG_FILE_BUFFER_SIZE, id, name,
+                                     strlen(name));
+    markCallsiteSent(id);
+}
+
+String FileSink::rotatedPath(const uint8_t index) const {
+    return path + "." + String(index);
+}
@@ -0,0 +1,82 @@
+#ifndef EZ_LOG_FILESINK_H
+#define EZ_LOG_FILESINK_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "LogSink.h"
+
+
+/**
+ * Size of the write buffer of a FileSink (one flash sector). The lines are collected, until it's full.
+ */
+#ifndef EZLOG_FILE_BUFFER_SIZE
+    #define EZLOG_FILE_BUFFER_SIZE    4096
+#endif
+
+
+/**
+ * Writes the log into files on a flash filesystem (LittleFS, SPIFFS, SD, ...).
+ *
+ * Lines are collected in a sector-sized buffer, which is written at once: when it's full, after flushIntervalMs,
+ * after each ERROR and on Log::flush(). A line is never split between two files. If the file would get bigger than
+ * maxFileSize, it's rotated:   /ezlog.log -> /ezlog.log.1 -> ... -> /ezlog.log.<maxFiles - 1> (deleted)
+ *
+ * After a power loss the file can end with an incomplete line (or binary record). It's cut off, before the file is
+ * continued, so the next line starts clean. In BINARY format each file gets the callsite names, it needs.
+ */
+class FileSink : public LogSink {
+public:
+    explicit FileSink(fs::FS& _filesystem, const char* _path = "/ezlog.log", size_t _maxFileSize = 64 * 1024,
+                      uint8_t _maxFiles = 4, Loglevel _loglevel = Loglevel::VERBOSE,
+                      LogFormat _format = LogFormat::PLAIN);
+    ~FileSink() override;
+
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    void write(const char* data, size_t len, Loglevel lineLoglevel) override;
+    void flush() override;
+    void poll() override;
+    bool wantsPoll() const override { return true; }
+
+    /**
+     * Writes the buffer and closes the file (f.e. before the filesystem is unmounted). The next line reopens it.
+     */
+    void close();
+
+    uint32_t flashWrites() const { return writes; }
+    uint32_t bytesWritten() const { return written; }
+    uint32_t recoveredBytes() const { return recovered; }   // cut off after a power loss
+
+    // Maximum time, a line stays in the buffer (checked with each line and by the writer task, see poll())
+    uint32_t flushIntervalMs = 1000;
+
+private:
+    bool open();
+    void recover();
+    size_t validLength(fs::File& current);
+    void writeBuffer();
+    void rotate();
+    void startFile(const char* data, size_t len);
+    String rotatedPath(uint8_t index) const;
+
+    fs::FS& filesystem;
+    String path;
+    size_t maxFileSize;
+    uint8_t maxFiles;
+
+    fs::File file;
+    char* buffer = nullptr;
+    size_t used = 0;
+    size_t fileSize = 0;
+    unsigned long lastFlush = 0;
+    bool recoveryDone = false;
+    bool openFailed = false;
+
+    uint32_t writes = 0;
+    uint32_t written = 0;
+    uint32_t recovered = 0;
+};
+
+
+#endif // EZ_LOG_FILESINK_H
@@ -0,0 +1,62 @@
+#include "LogFilter.h"
+
+LogFilter::LogFilter(const std::vector<LoggingElement>& elements) {
+    nodes.emplace_back();  // root = empty filter
+    uint32_t order = 0;
+    addElements(elements, order);
+    nodes.shrink_to_fit();
+}
+
+void LogFilter::addElements(const std::vector<LoggingElement>& elements, uint32_t& order) {
+    for (const auto& elem : elements) {
+        insert(elem, order++);
+        if (!elem.subElements.empty()) addElements(elem.subElements, order);
+    }
+}
+
+void LogFilter::insert(const LoggingElement& elem, const uint32_t order) {
+    uint32_t node = 0;
+    for (const char* c = elem.filter.c_str(); *c != '\0'; c++) {
+        uint32_t next = child(node, *c);
+        if (next == NONE) {
+            next = nodes.size();
+            Node newNode;
+            newNode.c = *c;
+            newNode.nextSibling = nodes[node].firstChild;
+            nodes.push_back(newNode);
+            nodes[node].firstChild = next;
+        }
+        node = next;
+    }
+
+    // Several elements with the same filter: the first one wins
+    if (nodes[node].order == NONE) {
+        nodes[node].order = order;
+        nodes[node].loglevel = elem.loglevel;
+        nodes[node].rateLimit = elem.rateLimit;
+    }
+}
+
+uint32_t LogFilter::child(const uint32_t node, const char c) const {
+    for (uint32_t idx = nodes[node].firstChild; idx != NONE; idx = nodes[idx].nextSibling) {
+        if (nodes[idx].c == c) return idx;
+    }
+    return NONE;
+}
+
+bool LogFilter::find(const char* prefix, Loglevel& loglevel, uint16_t* rateLimit) const {
+    // All filters on the path are matching, the one with the lowest order was found first by the old search:
+    uint32_t node = 0;
+    uint32_t best = 0;
+
+    for (const char* c = prefix; *c != '\0'; c++) {
+        node = child(node, *c);
+        if (node == NONE) break;
+        if (nodes[node].order < nodes[best].order) best = node;
+    }
+
+    if (nodes[best].order == NONE) return false;
+    loglevel = nodes[best].loglevel;
+    if (rateLimit != nullptr) *rateLimit = nodes[best].rateLimit;
+    return true;
+}
@@ -0,0 +1,48 @@
+#ifndef EZ_LOG_FILTER_H
+#define EZ_LOG_FILTER_H
+
+#include <Arduino.h>
+#include <vector>
+#include "structs.h"
+
+
+/**
+ * The customLoggingElements of a LoggingConfig, compiled into a prefix trie (by init() / updateConfig()).
+ *
+ * Same result as searching the LoggingElements depth-first for the first filter, which matches the beginning
+ * of the prefix - but with one walk over the prefix, no recursion and no allocation.
+ * Immutable after construction, so it can be read by all tasks without lock.
+ */
+class LogFilter {
+public:
+    explicit LogFilter(const std::vector<LoggingElement>& elements);
+
+    /**
+     * Searches the LoggingElement for "Class::method". Returns false, if no filter matches.
+     * rateLimit (optional) is set to the rate limit of the element (0 = not set).
+     */
+    bool find(const char* prefix, Loglevel& loglevel, uint16_t* rateLimit = nullptr) const;
+
+    size_t size() const { return nodes.size(); }
+
+private:
+    static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+    struct Node {
+        char c = 0;
+        uint32_t firstChild = NONE;
+        uint32_t nextSibling = NONE;
+        uint32_t order = NONE;          // position of the LoggingElement (depth-first), NONE = no filter ends here
+        Loglevel loglevel = Loglevel::WARN;
+        uint16_t rateLimit = 0;
+    };
+
+    void addElements(const std::vector<LoggingElement>& elements, uint32_t& order);
+    void insert(const LoggingElement& elem, uint32_t order);
+    uint32_t child(uint32_t node, char c) const;
+
+    std::vector<Node> nodes;
+};
+
+
+#endif // EZ_LOG_FILTER_H
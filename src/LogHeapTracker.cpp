@@ -0,0 +1,133 @@
+#include "LogHeapTracker.h"
+#include <algorithm>
+#include <mutex>
+
+LogHeapTracker::Entry* LogHeapTracker::table = nullptr;
+std::atomic<uint32_t> LogHeapTracker::used{0};
+std::atomic<uint32_t> LogHeapTracker::untracked{0};
+
+namespace {
+    std::mutex slotMutex;
+}
+
+void LogHeapTracker::enable() {
+    std::lock_guard<std::mutex> guard(slotMutex);
+    if (table != nullptr) return;
+    table = new Entry[EZLOG_HEAP_MAX_CALLSITES];
+}
+
+uint32_t LogHeapTracker::heapFree() {
+    return heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+}
+
+uint32_t LogHeapTracker::psramFree() {
+    return heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+}
+
+bool LogHeapTracker::record(const LogCallsite* callsite, const int32_t heapUsed, const int32_t psramUsed,
+                            const uint16_t leakThreshold) {
+    Entry* entry = entryFor(callsite);
+    if (entry == nullptr) {
+        untracked.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    entry->count.fetch_add(1, std::memory_order_relaxed);
+    entry->netHeap.fetch_add(heapUsed, std::memory_order_relaxed);
+    entry->netPsram.fetch_add(psramUsed, std::memory_order_relaxed);
+
+    int32_t peak = entry->peakHeap.load(std::memory_order_relaxed);
+    while (heapUsed > peak && !entry->peakHeap.compare_exchange_weak(peak, heapUsed, std::memory_order_relaxed)) {
+    }
+
+    if (heapUsed <= 0) {
+        entry->leakStreak.store(0, std::memory_order_relaxed);
+        return false;
+    }
+    entry->leakingCalls.fetch_add(1, std::memory_order_relaxed);
+    const uint32_t streak = entry->leakStreak.fetch_add(1, std::memory_order_relaxed) + 1;
+    return leakThreshold > 0 && streak >= leakThreshold && !entry->flagged.exchange(true, std::memory_order_relaxed);
+}
+
+/**
+ * Slot of the callsite. Assigned at the first call (under lock, so one callsite never gets two slots).
+ */
+LogHeapTracker::Entry* LogHeapTracker::entryFor(const LogCallsite* callsite) {
+    int32_t slot = callsite->heapSlot.load(std::memory_order_acquire);
+    if (slot == -1) {
+        std::lock_guard<std::mutex> guard(slotMutex);
+        slot = callsite->heapSlot.load(std::memory_order_relaxed);
+        if (slot == -1) {
+            const uint32_t next = used.load(std::memory_order_relaxed);
+            if (next < EZLOG_HEAP_MAX_CALLSITES) {
+                table[next].callsite = callsite;
+                used.store(next + 1, std::memory_order_release);
+                slot = static_cast<int32_t>(next);
+            } else {
+                slot = -2;
+            }
+            callsite->heapSlot.store(slot, std::memory_order_release);
+        }
+    }
+    return slot >= 0 ? &table[slot] : nullptr;
+}
+
+void LogHeapTracker::report(Print& out) {
+    char line[160];
+    if (table == nullptr) {
+        out.println("EZLog Heap: not enabled (LoggingConfig::heapTracking)");
+        return;
+    }
+
+    const uint32_t count = used.load(std::memory_order_acquire);
+    uint16_t order[EZLOG_HEAP_MAX_CALLSITES];
+    for (uint32_t i = 0; i < count; i++) order[i] = static_cast<uint16_t>(i);
+    std::sort(order, order + count, [](const uint16_t a, const uint16_t b) {
+        return table[a].netHeap.load(std::memory_order_relaxed) > table[b].netHeap.load(std::memory_order_relaxed);
+    });
+
+    out.println("EZLog Heap (bytes kept per scope = free at begin - free at end):");
+    snprintf(line, sizeof(line), "%10s %12s %12s %10s %10s %8s  %s",
+             "Calls", "Net Heap", "Net PSRAM", "Peak", "Leaking", "", "Callsite");
+    out.println(line);
+
+    for (uint32_t i = 0; i < count; i++) {
+        const Entry& entry = table[order[i]];
+        const uint32_t calls = entry.count.load(std::memory_order_relaxed);
+        if (calls == 0) continue;
+
+        snprintf(line, sizeof(line), "%10u %12lld %12lld %10d %10u %8s  %s",
+                 static_cast<unsigned>(calls),
+                 static_cast<long long>(entry.netHeap.load(std::memory_order_relaxed)),
+                 static_cast<long long>(entry.netPsram.load(std::memory_order_relaxed)),
+                 static_cast<int>(entry.peakHeap.load(std::memory_order_relaxed)),
+                 static_cast<unsigned>(entry.leakingCalls.load(std::memory_order_relaxed)),
+                 entry.flagged.load(std::memory_order_relaxed) ? "LEAK?" : "", entry.callsite->name);
+        out.println(line);
+    }
+
+    const uint32_t lost = untracked.load(std::memory_order_relaxed);
+    if (lost > 0) {
+        snprintf(line, sizeof(line), "%u calls untracked (more than EZLOG_HEAP_MAX_CALLSITES callsites)",
+                 static_cast<unsigned>(lost));
+        out.println(line);
+    }
+}
+
+/**
+ * Clears the statistics. The callsites keep their slots.
+ */
+void LogHeapTracker::reset() {
+    if (table == nullptr) return;
+    for (size_t i = 0; i < EZLOG_HEAP_MAX_CALLSITES; i++) {
+        Entry& entry = table[i];
+        entry.count.store(0, std::memory_order_relaxed);
+        entry.netHeap.store(0, std::memory_order_relaxed);
+        entry.netPsram.store(0, std::memory_order_relaxed);
+        entry.peakHeap.store(0, std::memory_order_relaxed);
+        entry.leakingCalls.store(0, std::memory_order_relaxed);
+        entry.leakStreak.store(0, std::memory_order_relaxed);
+        entry.flagged.store(false, std::memory_order_relaxed);
+    }
+    untracked.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,68 @@
+#ifndef EZ_LOG_HEAPTRACKER_H
+#define EZ_LOG_HEAPTRACKER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "LogCallsite.h"
+
+
+/**
+ * Maximum number of callsites, whose heap deltas are tracked (LoggingConfig::heapTracking).
+ * Further callsites are only counted as "untracked".
+ */
+#ifndef EZLOG_HEAP_MAX_CALLSITES
+    #define EZLOG_HEAP_MAX_CALLSITES    64
+#endif
+
+
+/**
+ * Compares the free heap (and PSRAM) at the begin and the end of each EZ_LOG()-scope and accumulates the difference
+ * per callsite: net allocation, largest allocation of a single call and the number of calls, which left less memory
+ * than they found. A callsite, which does this leakThreshold times in a row, is flagged as possible leak.
+ *
+ * The free size is global, so allocations of other tasks during the scope are counted, too - a single call says
+ * little, a callsite, which keeps losing memory over many calls, says a lot.
+ * Host builds get the free size from the counting allocator of the host stubs (heap_caps_get_free_size()).
+ */
+class LogHeapTracker {
+public:
+    static void enable();
+    static bool isEnabled() { return table != nullptr; }
+
+    /** Free size in bytes of the internal heap / of the PSRAM */
+    static uint32_t heapFree();
+    static uint32_t psramFree();
+
+    /**
+     * heapUsed/psramUsed = free size at the begin - free size at the end of the scope (> 0: memory was kept).
+     * Returns true, if this call flagged the callsite (leakThreshold calls in a row kept memory).
+     */
+    static bool record(const LogCallsite* callsite, int32_t heapUsed, int32_t psramUsed, uint16_t leakThreshold);
+
+    /**
+     * Prints the table, sorted by net heap allocation (descending)
+     */
+    static void report(Print& out);
+    static void reset();
+
+private:
+    struct Entry {
+        const LogCallsite* callsite = nullptr;
+        std::atomic<uint32_t> count{0};
+        std::atomic<int64_t> netHeap{0};
+        std::atomic<int64_t> netPsram{0};
+        std::atomic<int32_t> peakHeap{0};          // largest heapUsed of a single call
+        std::atomic<uint32_t> leakingCalls{0};     // calls with heapUsed > 0
+        std::atomic<uint32_t> leakStreak{0};       // ... in a row
+        std::atomic<bool> flagged{false};
+    };
+
+    static Entry* entryFor(const LogCallsite* callsite);
+
+    static Entry* table;
+    static std::atomic<uint32_t> used;
+    static std::atomic<uint32_t> untracked;
+};
+
+
+#endif // EZ_LOG_HEAPTRACKER_H
@@ -0,0 +1,264 @@
+#ifndef EZ_LOG_LINEBUFFER_H
+#define EZ_LOG_LINEBUFFER_H
+
+#include <Arduino.h>
+
+
+/**
+ * Maximum length of a single Log-Line (including ANSI-Colors).
+ * Each task owns three buffers of this size (line, partial line, printf-text). Longer lines will be truncated.
+ */
+#ifndef EZLOG_MAX_LINE_LENGTH
+    #define EZLOG_MAX_LINE_LENGTH     512
+#endif
+
+
+/**
+ * Fixed-size buffer, in which a Log-Line is assembled without any heap allocation.
+ * If the buffer is full, further text is silently dropped and isTruncated() returns true.
+ */
+class LogLineBuffer {
+public:
+    void clear() {
+        len = 0;
+        truncated = false;
+    }
+
+    void append(const char* str, size_t n) {
+        if (n > EZLOG_MAX_LINE_LENGTH - len) {
+            n = EZLOG_MAX_LINE_LENGTH - len;
+            truncated = true;
+        }
+        memcpy(buffer + len, str, n);
+        len += n;
+    }
+
+    void append(const char* str) { append(str, strlen(str)); }
+    void append(const String& str) { append(str.c_str(), str.length()); }
+    void append(const LogLineBuffer& other) { append(other.data(), other.length()); }
+
+    void append(const char c) {
+        if (len < EZLOG_MAX_LINE_LENGTH) buffer[len++] = c;
+        else truncated = true;
+    }
+
+    void appendRepeated(const char c, size_t count) {
+        if (count > EZLOG_MAX_LINE_LENGTH - len) {
+            count = EZLOG_MAX_LINE_LENGTH - len;
+            truncated = true;
+        }
+        memset(buffer + len, c, count);
+        len += count;
+    }
+
+    /** Unsigned number, padded with leading zeros to minDigits */
+    void appendNumber(uint32_t value, const uint8_t minDigits = 1) {
+        char digits[10];
+        uint8_t count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        while (count < minDigits && count < sizeof(digits)) digits[count++] = '0';
+        while (count > 0) append(digits[--count]);
+    }
+
+    /** Number with thousands separator (like EZLog::formatNumber) */
+    void appendGroupedNumber(const int32_t value, const char separator = '.') {
+        if (value < 0) append('-');
+        const uint32_t absValue = value < 0 ? 0u - static_cast<uint32_t>(value) : static_cast<uint32_t>(value);
+
+        char digits[10];
+        uint8_t count = 0;
+        uint32_t rest = absValue;
+        do {
+            digits[count++] = static_cast<char>('0' + rest % 10);
+            rest /= 10;
+        } while (rest != 0);
+        while (count > 0) {
+            append(digits[--count]);
+            if (count > 0 && count % 3 == 0) append(separator);
+        }
+    }
+
+    /**
+     * Removes redundant ANSI-Colors (LoggingConfig::terseColors): each run of color codes is replaced by a single
+     * code, which only changes what differs from the current color - or by nothing. The line starts and ends with
+     * the default color. Never makes the line longer (except for the final reset, if there's room for it).
+     */
+    void compactColors() {
+        const Sgr defaultColor{0, 0, 0, true};
+        Sgr current = defaultColor;     // what the terminal shows
+        size_t out = 0;
+        size_t pos = 0;
+        while (pos < len) {
+            if (buffer[pos] != '\033') {
+                buffer[out++] = buffer[pos++];
+                continue;
+            }
+
+            // Run of escape sequences without text in between:
+            const size_t runStart = pos;
+            Sgr target = current;
+            bool opaque = false;
+            while (pos < len && buffer[pos] == '\033') pos = applySgr(pos, target, opaque);
+
+            if (opaque || !target.valid) {
+                memmove(buffer + out, buffer + runStart, pos - runStart);
+                out += pos - runStart;
+                current = target;
+                current.valid = false;
+                continue;
+            }
+            if (target == current) continue;
+
+            char code[24];
+            const size_t codeLen = sgrChange(current, target, code);
+            if (codeLen <= pos - out) {
+                memcpy(buffer + out, code, codeLen);
+                out += codeLen;
+            } else {
+                memmove(buffer + out, buffer + runStart, pos - runStart);
+                out += pos - runStart;
+            }
+            current = target;
+        }
+        len = out;
+
+        // A line without the final reset (f.e. truncated) must not leave its color to the next one:
+        if (!(current == defaultColor) && len + 4 <= EZLOG_MAX_LINE_LENGTH) {
+            const bool newline = len > 0 && buffer[len - 1] == '\n';
+            if (newline) len--;
+            append("\033[0m", 4);
+            if (newline) append('\n');
+        }
+    }
+
+    /**
+     * Ends a truncated line with the reset of the colors and a newline, so its color doesn't leak into the next line.
+     * The text is cut in front of an escape sequence, which was truncated (else the terminal would take the reset
+     * as part of it).
+     */
+    void terminateLine() {
+        static const char ending[] = "\033[0m\n";
+        constexpr size_t endingLen = sizeof(ending) - 1;
+        size_t end = len < EZLOG_MAX_LINE_LENGTH - endingLen ? len : EZLOG_MAX_LINE_LENGTH - endingLen;
+
+        size_t escape = end;
+        while (escape > 0 && buffer[escape - 1] != '\033') escape--;
+        if (escape > 0 && !isSequenceComplete(escape - 1, end)) end = escape - 1;
+
+        len = end;
+        append(ending, endingLen);
+    }
+
+    /**
+     * Free space behind the text, f.e. to format directly into the buffer. grow() takes, what was written there.
+     */
+    char* tail() { return buffer + len; }
+    size_t available() const { return EZLOG_MAX_LINE_LENGTH - len; }
+    void grow(const size_t n) { len += n < available() ? n : available(); }
+
+    /** Drops everything behind the first n chars */
+    void shrink(const size_t n) {
+        if (n < len) len = n;
+    }
+
+    const char* data() const { return buffer; }
+    size_t length() const { return len; }
+    bool empty() const { return len == 0; }
+    bool isTruncated() const { return truncated; }
+
+private:
+    /** Color state of the terminal (0 = default). valid = false: unknown (after an unsupported sequence) */
+    struct Sgr {
+        uint8_t bold;
+        uint8_t fg;
+        uint8_t bg;
+        bool valid;
+
+        bool operator==(const Sgr& other) const {
+            return valid && other.valid && bold == other.bold && fg == other.fg && bg == other.bg;
+        }
+    };
+
+    /**
+     * True, if the escape sequence at pos ends before end (CSI: "ESC [" parameters, intermediates and a final byte)
+     */
+    bool isSequenceComplete(size_t pos, const size_t end) const {
+        if (++pos >= end) return false;
+        if (buffer[pos] != '[') return true;
+        while (++pos < end) {
+            if (buffer[pos] >= 0x40 && buffer[pos] <= 0x7E) return true;
+        }
+        return false;
+    }
+
+    /**
+     * Applies the sequence at pos to state and returns the position behind it.
+     * Sequences, which aren't simple colors, set opaque (the run is copied unchanged).
+     */
+    size_t applySgr(size_t pos, Sgr& state, bool& opaque) const {
+        if (pos + 1 >= len || buffer[pos + 1] != '[') {
+            opaque = true;
+            return pos + 1;
+        }
+        pos += 2;
+        uint32_t param = 0;
+        while (pos < len) {
+            const char c = buffer[pos++];
+            if (c >= '0' && c <= '9') {
+                param = param * 10 + (c - '0');
+                continue;
+            }
+            if (c != ';' && c != 'm') {
+                // Other sequence (f.e. cursor movement): skip to its final byte
+                opaque = true;
+                if (c >= 0x40 && c <= 0x7E) return pos;
+                while (pos < len && (buffer[pos] < 0x40 || buffer[pos] > 0x7E)) pos++;
+                return pos < len ? pos + 1 : pos;
+            }
+
+            if (param == 0) state = Sgr{0, 0, 0, true};
+            else if (param == 1) state.bold = 1;
+            else if (param == 22) state.bold = 0;
+            else if ((param >= 30 && param <= 37) || (param >= 90 && param <= 97)) state.fg = param;
+            else if (param == 39) state.fg = 0;
+            else if ((param >= 40 && param <= 47) || (param >= 100 && param <= 107)) state.bg = param;
+            else if (param == 49) state.bg = 0;
+            else opaque = true;
+            param = 0;
+            if (c == 'm') return pos;
+        }
+        opaque = true;
+        return pos;
+    }
+
+    /** Writes the shortest code from "from" to "to" (a reset, if something has to be switched off) */
+    static size_t sgrChange(const Sgr& from, const Sgr& to, char* code) {
+        const bool reset = !from.valid || (from.bold && !to.bold) || (from.fg && !to.fg) || (from.bg && !to.bg);
+        size_t n = 0;
+        code[n++] = '\033';
+        code[n++] = '[';
+        if (reset) code[n++] = '0';
+        const auto param = [&](const uint8_t value, const bool changed) {
+            if (value == 0 || !(reset || changed)) return;
+            if (code[n - 1] != '[') code[n++] = ';';
+            if (value >= 100) code[n++] = '1';
+            if (value >= 10) code[n++] = static_cast<char>('0' + (value / 10) % 10);
+            code[n++] = static_cast<char>('0' + value % 10);
+        };
+        param(to.bold, to.bold != from.bold);
+        param(to.fg, to.fg != from.fg);
+        param(to.bg, to.bg != from.bg);
+        code[n++] = 'm';
+        return n;
+    }
+
+    char buffer[EZLOG_MAX_LINE_LENGTH];
+    size_t len = 0;
+    bool truncated = false;
+};
+
+
+#endif // EZ_LOG_LINEBUFFER_H
@@ -0,0 +1,48 @@
+#include "LogMemInfo.h"
+
+constexpr uint32_t LogMemInfo::NONE;
+
+std::atomic<uint32_t> LogMemInfo::heapFree{0};
+std::atomic<uint32_t> LogMemInfo::heapLargestBlock{0};
+std::atomic<uint32_t> LogMemInfo::psramFree{0};
+std::atomic<uint32_t> LogMemInfo::sampledAt{0};
+std::atomic<bool> LogMemInfo::stale{true};
+std::atomic<uint32_t> LogMemInfo::queryCount{0};
+std::atomic<uint32_t> LogMemInfo::printedHeapFree{LogMemInfo::NONE};
+std::atomic<uint32_t> LogMemInfo::printedHeapLargestBlock{LogMemInfo::NONE};
+std::atomic<uint32_t> LogMemInfo::printedPsramFree{LogMemInfo::NONE};
+
+LogMemSample LogMemInfo::get(const MemInfoSampling sampling, const uint32_t intervalMs) {
+    if (sampling == MemInfoSampling::EACH_LINE) return query();
+
+    const uint32_t now = millis();
+    const bool expired = sampling == MemInfoSampling::INTERVAL &&
+                         now - sampledAt.load(std::memory_order_relaxed) >= intervalMs;
+    if (expired || stale.load(std::memory_order_relaxed)) {
+        // Several tasks may refresh at the same time - only costs the query, the values are the same
+        stale.store(false, std::memory_order_relaxed);
+        sampledAt.store(now, std::memory_order_relaxed);
+        const LogMemSample sample = query();
+        heapFree.store(sample.heapFree, std::memory_order_relaxed);
+        heapLargestBlock.store(sample.heapLargestBlock, std::memory_order_relaxed);
+        psramFree.store(sample.psramFree, std::memory_order_relaxed);
+        return sample;
+    }
+
+    return {heapFree.load(std::memory_order_relaxed), heapLargestBlock.load(std::memory_order_relaxed),
+            psramFree.load(std::memory_order_relaxed)};
+}
+
+bool LogMemInfo::exchangePrinted(const LogMemSample& sample, LogMemSample& previous) {
+    previous.heapFree = printedHeapFree.exchange(sample.heapFree, std::memory_order_relaxed);
+    previous.heapLargestBlock = printedHeapLargestBlock.exchange(sample.heapLargestBlock, std::memory_order_relaxed);
+    previous.psramFree = printedPsramFree.exchange(sample.psramFree, std::memory_order_relaxed);
+    return previous != sample;
+}
+
+LogMemSample LogMemInfo::query() {
+    queryCount.fetch_add(1, std::memory_order_relaxed);
+    return {static_cast<uint32_t>(heap_caps_get_free_size(MALLOC_CAP_DMA) / 1024),
+            static_cast<uint32_t>(heap_caps_get_largest_free_block(MALLOC_CAP_DMA) / 1024),
+            static_cast<uint32_t>(heap_caps_get_free_size(MALLOC_CAP_8BIT) / 1024)};
+}
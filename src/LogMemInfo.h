@@ -0,0 +1,70 @@
+#ifndef EZ_LOG_MEMINFO_H
+#define EZ_LOG_MEMINFO_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "structs.h"
+
+
+/**
+ * Memory-Info of a line (LoggingConfig::addMemInfo), in kB
+ */
+struct LogMemSample {
+    uint32_t heapFree;          // free DMA-capable heap
+    uint32_t heapLargestBlock;  // largest free block of it
+    uint32_t psramFree;         // free 8-bit capable memory (incl. PSRAM)
+
+    bool operator==(const LogMemSample& other) const {
+        return heapFree == other.heapFree && heapLargestBlock == other.heapLargestBlock && psramFree == other.psramFree;
+    }
+    bool operator!=(const LogMemSample& other) const { return !(*this == other); }
+};
+
+
+/**
+ * Cache for the memory-info: each heap_caps_get_...() walks the heap under a lock, three of them for each line
+ * cost more than the rest of the line. Depending on LoggingConfig::memInfoSampling, the values are only refreshed
+ * every memInfoIntervalMs or at the end of a scope, all tasks share the cache.
+ *
+ * The values are stored in separate atomics, so a reader can get two fields from consecutive samples - which doesn't
+ * matter for a log line.
+ */
+class LogMemInfo {
+public:
+    /**
+     * Current values, refreshed if the sampling mode requires it
+     */
+    static LogMemSample get(MemInfoSampling sampling, uint32_t intervalMs);
+
+    /**
+     * The next get() queries the heap again (MemInfoSampling::SCOPE_END: called at the end of each scope)
+     */
+    static void invalidate() { stale.store(true, std::memory_order_relaxed); }
+
+    /**
+     * memInfoOnlyChanges: remembers sample as printed and returns the previous one in previous.
+     * Returns false, if both are equal. previous.heapFree = NONE, if nothing was printed yet.
+     */
+    static bool exchangePrinted(const LogMemSample& sample, LogMemSample& previous);
+    static constexpr uint32_t NONE = 0xFFFFFFFF;
+
+    /** Number of heap queries (each one = 3 calls of heap_caps_...) */
+    static uint32_t queries() { return queryCount.load(std::memory_order_relaxed); }
+
+private:
+    static LogMemSample query();
+
+    static std::atomic<uint32_t> heapFree;
+    static std::atomic<uint32_t> heapLargestBlock;
+    static std::atomic<uint32_t> psramFree;
+    static std::atomic<uint32_t> sampledAt;
+    static std::atomic<bool> stale;
+    static std::atomic<uint32_t> queryCount;
+
+    static std::atomic<uint32_t> printedHeapFree;
+    static std::atomic<uint32_t> printedHeapLargestBlock;
+    static std::atomic<uint32_t> printedPsramFree;
+};
+
+
+#endif // EZ_LOG_MEMINFO_H
@@ -0,0 +1,224 @@
+#include "LogPrintf.h"
+#include <math.h>
+
+size_t LogPrintf::format(char* dest, const size_t size, const char* format, va_list args) {
+    if (!isSupported(format)) {
+        const int written = vsnprintf(dest, size, format, args);
+        if (written < 0) {
+            if (size > 0) dest[0] = '\0';
+            return 0;
+        }
+        return static_cast<size_t>(written) < size ? written : (size > 0 ? size - 1 : 0);
+    }
+
+    Writer out(dest, size);
+    const char* pos = format;
+    while (*pos != '\0') {
+        if (*pos != '%') {
+            out.append(*pos++);
+            continue;
+        }
+
+        Spec spec;
+        pos = parseSpec(pos + 1, spec);
+        switch (spec.conversion) {
+            case '%':
+                out.append('%');
+                break;
+            case 'd':
+            case 'i': {
+                const long value = spec.isLong ? va_arg(args, long) : va_arg(args, int);
+                writeInteger(out, spec, value, 0, true);
+                break;
+            }
+            case 'u':
+            case 'x':
+            case 'X': {
+                const unsigned long value = spec.isLong ? va_arg(args, unsigned long) : va_arg(args, unsigned int);
+                writeInteger(out, spec, 0, value, false);
+                break;
+            }
+            case 'c': {
+                const char c = static_cast<char>(va_arg(args, int));
+                writePadded(out, spec, "", 0, &c, 1);
+                break;
+            }
+            case 's': {
+                const char* str = va_arg(args, const char*);
+                if (str == nullptr) str = "(null)";
+                size_t len = 0;
+                while (str[len] != '\0' && (spec.precision < 0 || len < static_cast<size_t>(spec.precision))) len++;
+                writePadded(out, spec, "", 0, str, len);
+                break;
+            }
+            case 'f':
+            case 'F':
+                writeFloat(out, spec, va_arg(args, double));
+                break;
+            default:
+                break;
+        }
+    }
+    return out.finish();
+}
+
+/**
+ * True, if all conversions of the format can be rendered without vsnprintf()
+ */
+bool LogPrintf::isSupported(const char* format) {
+    for (const char* pos = format; *pos != '\0'; pos++) {
+        if (*pos != '%') continue;
+        Spec spec;
+        pos = parseSpec(pos + 1, spec);
+        if (spec.conversion == 0) return false;
+        if (spec.isLong && (spec.conversion == 'c' || spec.conversion == 's')) return false;
+        pos--;
+    }
+    return true;
+}
+
+/**
+ * Parses "[flags][width][.precision][l]conversion" (behind the '%'). spec.conversion = 0, if it's not supported.
+ */
+const char* LogPrintf::parseSpec(const char* pos, Spec& spec) {
+    for (;; pos++) {
+        if (*pos == '-') spec.leftAlign = true;
+        else if (*pos == '0') spec.zeroPad = true;
+        else if (*pos == '+') spec.sign = '+';
+        else if (*pos == ' ' && spec.sign != '+') spec.sign = ' ';
+        else break;
+    }
+    while (*pos >= '0' && *pos <= '9') spec.width = spec.width * 10 + (*pos++ - '0');
+    if (*pos == '.') {
+        pos++;
+        spec.precision = 0;
+        while (*pos >= '0' && *pos <= '9') spec.precision = spec.precision * 10 + (*pos++ - '0');
+    }
+    if (*pos == 'l') {
+        spec.isLong = true;
+        pos++;
+    }
+
+    switch (*pos) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'c': case 's': case 'f': case 'F': case '%':
+            spec.conversion = *pos;
+            return pos + 1;
+        default:
+            spec.conversion = 0;
+            return *pos == '\0' ? pos : pos + 1;
+    }
+}
+
+void LogPrintf::writePadded(Writer& out, const Spec& spec, const char* prefix, const size_t prefixLen,
+                            const char* body, const size_t bodyLen) {
+    const size_t padding = spec.width > prefixLen + bodyLen ? spec.width - prefixLen - bodyLen : 0;
+    const bool numeric = spec.conversion != 's' && spec.conversion != 'c';
+
+    if (spec.leftAlign) {
+        out.append(prefix, prefixLen);
+        out.append(body, bodyLen);
+        out.pad(' ', padding);
+    } else if (numeric && spec.zeroPad) {
+        out.append(prefix, prefixLen);
+        out.pad('0', padding);
+        out.append(body, bodyLen);
+    } else {
+        out.pad(' ', padding);
+        out.append(prefix, prefixLen);
+        out.append(body, bodyLen);
+    }
+}
+
+void LogPrintf::writeInteger(Writer& out, const Spec& spec, const long value, unsigned long uvalue,
+                             const bool isSigned) {
+    char sign = 0;
+    if (isSigned) {
+        sign = value < 0 ? '-' : spec.sign;
+        uvalue = value < 0 ? 0ul - static_cast<unsigned long>(value) : static_cast<unsigned long>(value);
+    }
+
+    const unsigned base = (spec.conversion == 'x' || spec.conversion == 'X') ? 16 : 10;
+    const char* digitChars = spec.conversion == 'X' ? "0123456789ABCDEF" : "0123456789abcdef";
+
+    // Digits backwards, then the zeros of the precision:
+    char digits[24];
+    size_t count = 0;
+    while (uvalue != 0) {
+        digits[count++] = digitChars[uvalue % base];
+        uvalue /= base;
+    }
+    if (spec.precision < 0 && count == 0) digits[count++] = '0';
+    while (count < static_cast<size_t>(spec.precision > 0 ? spec.precision : 0) && count < sizeof(digits)) {
+        digits[count++] = '0';
+    }
+
+    char body[24];
+    for (size_t i = 0; i < count; i++) body[i] = digits[count - 1 - i];
+
+    Spec numberSpec = spec;
+    if (spec.precision >= 0) numberSpec.zeroPad = false;    // like printf: precision disables the '0'-flag
+    writePadded(out, numberSpec, &sign, sign != 0 ? 1 : 0, body, count);
+}
+
+void LogPrintf::writeFloat(Writer& out, const Spec& spec, const double value) {
+    const char sign = signbit(value) ? '-' : spec.sign;
+    const double absValue = fabs(value);
+    const uint8_t precision = spec.precision < 0 ? 6 : static_cast<uint8_t>(spec.precision > 30 ? 30 : spec.precision);
+    char body[48];
+    size_t len = 0;
+
+    if (isnan(value) || isinf(value)) {
+        const bool upper = spec.conversion == 'F';
+        const char* text = isnan(value) ? (upper ? "NAN" : "nan") : (upper ? "INF" : "inf");
+        Spec textSpec = spec;
+        textSpec.zeroPad = false;
+        writePadded(out, textSpec, &sign, sign != 0 ? 1 : 0, text, 3);
+        return;
+    }
+
+    if (absValue < 4294967295.0 && precision <= 9) {
+        // Fast path: integer part and fraction as uint32
+        uint32_t scale = 1;
+        for (uint8_t i = 0; i < precision; i++) scale *= 10;
+        uint32_t intPart = static_cast<uint32_t>(absValue);
+        const double scaled = (absValue - intPart) * scale;
+        uint32_t fraction = static_cast<uint32_t>(scaled);
+
+        // Round half to even, like printf for exact ties (2.5 -> "2"). The multiplication can round a value
+        // close to .5 to exactly .5 (0.05 -> 0.5), so the direction is checked without rounding (fma):
+        const double rest = scaled - fraction;
+        if (rest > 0.5) {
+            fraction++;
+        } else if (rest == 0.5) {
+            const double exactRest = fma(absValue - intPart, 2.0 * scale, -(2.0 * fraction + 1));
+            const bool lastDigitOdd = precision > 0 ? (fraction & 1) : (intPart & 1);
+            if (exactRest > 0 || (exactRest == 0 && lastDigitOdd)) fraction++;
+        }
+        if (fraction >= scale) {
+            intPart++;
+            fraction -= scale;
+        }
+
+        char digits[10];
+        size_t count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + intPart % 10);
+            intPart /= 10;
+        } while (intPart != 0);
+        while (count > 0) body[len++] = digits[--count];
+
+        if (precision > 0) {
+            body[len++] = '.';
+            for (size_t i = precision; i > 0; i--) {
+                body[len + i - 1] = static_cast<char>('0' + fraction % 10);
+                fraction /= 10;
+            }
+            len += precision;
+        }
+    } else {
+        const int written = snprintf(body, sizeof(body), "%.*f", static_cast<int>(precision), absValue);
+        len = written < 0 ? 0 : (static_cast<size_t>(written) < sizeof(body) ? written : sizeof(body) - 1);
+    }
+
+    writePadded(out, spec, &sign, sign != 0 ? 1 : 0, body, len);
+}
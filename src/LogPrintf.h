@@ -0,0 +1,66 @@
+#ifndef EZ_LOG_PRINTF_H
+#define EZ_LOG_PRINTF_H
+
+#include <Arduino.h>
+#include <stdarg.h>
+
+
+/**
+ * printf-Formatting for Log::debugf() etc., without heap allocation.
+ *
+ * The common conversions (%d %i %u %x %X %c %s %f %% with flags "-0+ ", width, precision and the length "l") are
+ * rendered directly. Formats with anything else (f.e. %e, %g, %p, %lld, "*"-width) are passed to vsnprintf().
+ * Floats up to 2^32 and with up to 9 decimals are rendered with integer arithmetic (the last digit can differ from
+ * printf in rare cases), the rest by snprintf().
+ */
+class LogPrintf {
+public:
+    /**
+     * Writes the formatted text into dest (always null-terminated, truncated if necessary).
+     * Returns the length of the written text.
+     */
+    static size_t format(char* dest, size_t size, const char* format, va_list args);
+
+private:
+    struct Spec {
+        bool leftAlign = false;
+        bool zeroPad = false;
+        char sign = 0;          // '+', ' ' or 0
+        uint16_t width = 0;
+        int16_t precision = -1;
+        bool isLong = false;
+        char conversion = 0;
+    };
+
+    class Writer {
+    public:
+        Writer(char* _dest, size_t _size) : dest(_dest), size(_size) {}
+        void append(char c) {
+            if (len + 1 < size) dest[len++] = c;
+        }
+        void append(const char* str, size_t n) {
+            while (n-- > 0) append(*str++);
+        }
+        void pad(char c, size_t count) {
+            while (count-- > 0) append(c);
+        }
+        size_t finish() {
+            if (size > 0) dest[len] = '\0';
+            return len;
+        }
+    private:
+        char* dest;
+        size_t size;
+        size_t len = 0;
+    };
+
+    static bool isSupported(const char* format);
+    static const char* parseSpec(const char* pos, Spec& spec);
+    static void writePadded(Writer& out, const Spec& spec, const char* prefix, size_t prefixLen, const char* body,
+                            size_t bodyLen);
+    static void writeInteger(Writer& out, const Spec& spec, long value, unsigned long uvalue, bool isSigned);
+    static void writeFloat(Writer& out, const Spec& spec, double value);
+};
+
+
+#endif // EZ_LOG_PRINTF_H
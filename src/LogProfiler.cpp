@@ -0,0 +1,160 @@
+#include "LogProfiler.h"
+#include <algorithm>
+#include <mutex>
+
+LogProfiler::Entry* LogProfiler::table = nullptr;
+std::atomic<uint32_t> LogProfiler::used{0};
+std::atomic<uint32_t> LogProfiler::untracked{0};
+
+namespace {
+    std::mutex slotMutex;
+}
+
+void LogProfiler::enable() {
+    std::lock_guard<std::mutex> guard(slotMutex);
+    if (table != nullptr) return;
+    auto* newTable = new Entry[EZLOG_PROFILE_MAX_CALLSITES];
+    for (size_t i = 0; i < EZLOG_PROFILE_MAX_CALLSITES; i++) {
+        for (auto& bucketCount : newTable[i].histogram) bucketCount.store(0, std::memory_order_relaxed);
+    }
+    table = newTable;
+}
+
+void LogProfiler::record(const LogCallsite* callsite, const uint32_t durationUs) {
+    Entry* entry = entryFor(callsite);
+    if (entry == nullptr) {
+        untracked.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    entry->count.fetch_add(1, std::memory_order_relaxed);
+    entry->totalUs.fetch_add(durationUs, std::memory_order_relaxed);
+    entry->histogram[bucket(durationUs)].fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t current = entry->minUs.load(std::memory_order_relaxed);
+    while (durationUs < current && !entry->minUs.compare_exchange_weak(current, durationUs, std::memory_order_relaxed)) {
+    }
+    current = entry->maxUs.load(std::memory_order_relaxed);
+    while (durationUs > current && !entry->maxUs.compare_exchange_weak(current, durationUs, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * Slot of the callsite. Assigned at the first call (under lock, so one callsite never gets two slots).
+ */
+LogProfiler::Entry* LogProfiler::entryFor(const LogCallsite* callsite) {
+    int32_t slot = callsite->profileSlot.load(std::memory_order_acquire);
+    if (slot == -1) {
+        std::lock_guard<std::mutex> guard(slotMutex);
+        slot = callsite->profileSlot.load(std::memory_order_relaxed);
+        if (slot == -1) {
+            const uint32_t next = used.load(std::memory_order_relaxed);
+            if (next < EZLOG_PROFILE_MAX_CALLSITES) {
+                table[next].callsite = callsite;
+                used.store(next + 1, std::memory_order_release);
+                slot = static_cast<int32_t>(next);
+            } else {
+                slot = -2;
+            }
+            callsite->profileSlot.store(slot, std::memory_order_release);
+        }
+    }
+    return slot >= 0 ? &table[slot] : nullptr;
+}
+
+uint8_t LogProfiler::bucket(uint32_t durationUs) {
+    uint8_t n = 0;
+    while (durationUs != 0 && n < EZLOG_PROFILE_HISTOGRAM_BUCKETS - 1) {
+        durationUs >>= 1;
+        n++;
+    }
+    return n;
+}
+
+/**
+ * Upper bound of the bucket, which contains the percentile (so it's only accurate to a factor of 2)
+ */
+uint32_t LogProfiler::percentile(const Entry& entry, const uint32_t count, const uint8_t percent) {
+    const uint64_t target = (static_cast<uint64_t>(count) * percent + 99) / 100;
+    uint64_t sum = 0;
+    for (uint8_t n = 0; n < EZLOG_PROFILE_HISTOGRAM_BUCKETS; n++) {
+        sum += entry.histogram[n].load(std::memory_order_relaxed);
+        if (sum >= target) return n == 0 ? 0 : (1u << n) - 1;
+    }
+    return UINT32_MAX;
+}
+
+void LogProfiler::report(Print& out, const bool histogram) {
+    char line[160];
+    if (table == nullptr) {
+        out.println("EZLog Profiler: not enabled (LoggingConfig::profiling)");
+        return;
+    }
+
+    const uint32_t count = used.load(std::memory_order_acquire);
+    uint16_t order[EZLOG_PROFILE_MAX_CALLSITES];
+    for (uint32_t i = 0; i < count; i++) order[i] = static_cast<uint16_t>(i);
+    std::sort(order, order + count, [](const uint16_t a, const uint16_t b) {
+        return table[a].totalUs.load(std::memory_order_relaxed) > table[b].totalUs.load(std::memory_order_relaxed);
+    });
+
+    out.println("EZLog Profiler (durations in us, p50/p99 from the histogram):");
+    snprintf(line, sizeof(line), "%10s %12s %10s %10s %10s %10s %10s  %s",
+             "Calls", "Total", "Min", "Max", "Mean", "p50", "p99", "Callsite");
+    out.println(line);
+
+    for (uint32_t i = 0; i < count; i++) {
+        const Entry& entry = table[order[i]];
+        const uint32_t calls = entry.count.load(std::memory_order_relaxed);
+        if (calls == 0) continue;
+        const uint64_t total = entry.totalUs.load(std::memory_order_relaxed);
+
+        snprintf(line, sizeof(line), "%10u %12llu %10u %10u %10u %10u %10u  %s",
+                 static_cast<unsigned>(calls), static_cast<unsigned long long>(total),
+                 static_cast<unsigned>(entry.minUs.load(std::memory_order_relaxed)),
+                 static_cast<unsigned>(entry.maxUs.load(std::memory_order_relaxed)),
+                 static_cast<unsigned>(total / calls),
+                 static_cast<unsigned>(percentile(entry, calls, 50)),
+                 static_cast<unsigned>(percentile(entry, calls, 99)), entry.callsite->name);
+        out.println(line);
+
+        if (histogram) {
+            // "<2^n: count" for each non-empty bucket
+            out.print("           ");
+            for (uint8_t n = 0; n < EZLOG_PROFILE_HISTOGRAM_BUCKETS; n++) {
+                const uint32_t bucketCount = entry.histogram[n].load(std::memory_order_relaxed);
+                if (bucketCount == 0) continue;
+                if (n == EZLOG_PROFILE_HISTOGRAM_BUCKETS - 1) {
+                    snprintf(line, sizeof(line), " >=%lu:%u", 1ul << (n - 1), static_cast<unsigned>(bucketCount));
+                } else {
+                    snprintf(line, sizeof(line), " <%lu:%u", 1ul << n, static_cast<unsigned>(bucketCount));
+                }
+                out.print(line);
+            }
+            out.println();
+        }
+    }
+
+    const uint32_t lost = untracked.load(std::memory_order_relaxed);
+    if (lost > 0) {
+        snprintf(line, sizeof(line), "%u calls untracked (more than EZLOG_PROFILE_MAX_CALLSITES callsites)",
+                 static_cast<unsigned>(lost));
+        out.println(line);
+    }
+}
+
+/**
+ * Clears the statistics. The callsites keep their slots.
+ */
+void LogProfiler::reset() {
+    if (table == nullptr) return;
+    for (size_t i = 0; i < EZLOG_PROFILE_MAX_CALLSITES; i++) {
+        Entry& entry = table[i];
+        entry.count.store(0, std::memory_order_relaxed);
+        entry.totalUs.store(0, std::memory_order_relaxed);
+        entry.minUs.store(UINT32_MAX, std::memory_order_relaxed);
+        entry.maxUs.store(0, std::memory_order_relaxed);
+        for (auto& bucketCount : entry.histogram) bucketCount.store(0, std::memory_order_relaxed);
+    }
+    untracked.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,63 @@
+#ifndef EZ_LOG_PROFILER_H
+#define EZ_LOG_PROFILER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "LogCallsite.h"
+
+
+/**
+ * Maximum number of callsites, which are aggregated by the profiler (LoggingConfig::profiling).
+ * Further callsites are only counted as "untracked".
+ */
+#ifndef EZLOG_PROFILE_MAX_CALLSITES
+    #define EZLOG_PROFILE_MAX_CALLSITES    64
+#endif
+
+/**
+ * Buckets of the latency histogram: bucket n counts durations < 2^n µs, the last one everything above.
+ */
+#define EZLOG_PROFILE_HISTOGRAM_BUCKETS    24
+
+
+/**
+ * Aggregates the duration of EZ_LOG()-scopes per callsite - independent of the loglevel and printStartEndMessages.
+ *
+ * The table is allocated once, when profiling is enabled for the first time. Updates are lock-free (atomics),
+ * so all tasks can record at the same time.
+ */
+class LogProfiler {
+public:
+    static void enable();
+    static bool isEnabled() { return table != nullptr; }
+
+    static void record(const LogCallsite* callsite, uint32_t durationUs);
+
+    /**
+     * Prints the table, sorted by total time (descending). With histogram=true the latency histogram of each callsite
+     * is printed in an additional line.
+     */
+    static void report(Print& out, bool histogram);
+    static void reset();
+
+private:
+    struct Entry {
+        const LogCallsite* callsite = nullptr;
+        std::atomic<uint32_t> count{0};
+        std::atomic<uint64_t> totalUs{0};
+        std::atomic<uint32_t> minUs{UINT32_MAX};
+        std::atomic<uint32_t> maxUs{0};
+        std::atomic<uint32_t> histogram[EZLOG_PROFILE_HISTOGRAM_BUCKETS];
+    };
+
+    static Entry* entryFor(const LogCallsite* callsite);
+    static uint8_t bucket(uint32_t durationUs);
+    static uint32_t percentile(const Entry& entry, uint32_t count, uint8_t percent);
+
+    static Entry* table;
+    static std::atomic<uint32_t> used;
+    static std::atomic<uint32_t> untracked;
+};
+
+
+#endif // EZ_LOG_PROFILER_H
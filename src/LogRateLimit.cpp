@@ -0,0 +1,42 @@
+#include "LogRateLimit.h"
+
+/**
+ * Bucket of a callsite: (time of the last update in ms << 32) | tokens in 1/1000. 0 = not used yet (full).
+ */
+uint32_t LogRateLimit::tokens(const uint64_t bucket, const uint16_t perSecond, const uint16_t burst,
+                              const uint32_t nowMs) {
+    const uint64_t full = static_cast<uint64_t>(burst > 0 ? burst : 1) * 1000;
+    if (bucket == 0) return static_cast<uint32_t>(full);
+
+    // 1 token per second = 1/1000 token per ms. Another task may have stored a later time in the meantime:
+    const int32_t elapsedMs = std::max<int32_t>(static_cast<int32_t>(nowMs - static_cast<uint32_t>(bucket >> 32)), 0);
+    const uint64_t refilled = (bucket & 0xFFFFFFFF) + static_cast<uint64_t>(elapsedMs) * perSecond;
+    return static_cast<uint32_t>(std::min(refilled, full));
+}
+
+bool LogRateLimit::acquire(const LogCallsite* callsite, const uint16_t perSecond, const uint16_t burst,
+                           const uint32_t nowMs) {
+    uint64_t bucket = callsite->rateBucket.load(std::memory_order_relaxed);
+    while (true) {
+        uint32_t available = tokens(bucket, perSecond, burst, nowMs);
+        const bool granted = available >= 1000;
+        if (granted) available -= 1000;
+
+        uint64_t updated = (static_cast<uint64_t>(nowMs) << 32) | available;
+        if (updated == 0) updated = 1;
+        if (callsite->rateBucket.compare_exchange_weak(bucket, updated, std::memory_order_relaxed)) return granted;
+    }
+}
+
+bool LogRateLimit::available(const LogCallsite* callsite, const uint16_t perSecond, const uint16_t burst,
+                             const uint32_t nowMs) {
+    return tokens(callsite->rateBucket.load(std::memory_order_relaxed), perSecond, burst, nowMs) >= 1000;
+}
+
+uint32_t LogRateLimit::hash(const Loglevel loglevel, const char* msg1, const size_t len1, const char* msg2,
+                            const size_t len2) {
+    uint32_t hash = 2166136261u ^ static_cast<uint32_t>(loglevel);
+    for (size_t i = 0; i < len1; i++) hash = (hash ^ static_cast<uint8_t>(msg1[i])) * 16777619u;
+    for (size_t i = 0; i < len2; i++) hash = (hash ^ static_cast<uint8_t>(msg2[i])) * 16777619u;
+    return hash;
+}
@@ -0,0 +1,42 @@
+#ifndef EZ_LOG_RATELIMIT_H
+#define EZ_LOG_RATELIMIT_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "structs.h"
+#include "LogCallsite.h"
+
+
+/**
+ * Protects the output against a single callsite, which logs in a tight loop:
+ *  - Token bucket per callsite (LoggingConfig::rateLimit / LoggingElement::rateLimit): each line takes a token,
+ *    the bucket is refilled with rateLimit tokens per second, up to rateLimitBurst. Without token the line is dropped.
+ *  - Repeat suppression (LoggingConfig::suppressRepeats): a message, which is identical to the previous one of the
+ *    callsite, is only counted, until another message arrives ("last message repeated N times").
+ *
+ * Both are checked with the raw message, before the lock is taken and anything is formatted. The state lives in the
+ * LogCallsite and is updated lock-free, so all tasks can use it at the same time.
+ */
+class LogRateLimit {
+public:
+    /**
+     * Takes a token from the bucket of the callsite. Returns false, if it's empty (the line has to be dropped).
+     */
+    static bool acquire(const LogCallsite* callsite, uint16_t perSecond, uint16_t burst, uint32_t nowMs);
+
+    /**
+     * Same as acquire(), but doesn't take the token (for Log::isEnabled(), so the message isn't even built).
+     */
+    static bool available(const LogCallsite* callsite, uint16_t perSecond, uint16_t burst, uint32_t nowMs);
+
+    /**
+     * Hash of a message (FNV-1a over both parts and the loglevel), to detect repeats without storing the text
+     */
+    static uint32_t hash(Loglevel loglevel, const char* msg1, size_t len1, const char* msg2, size_t len2);
+
+private:
+    static uint32_t tokens(uint64_t bucket, uint16_t perSecond, uint16_t burst, uint32_t nowMs);
+};
+
+
+#endif // EZ_LOG_RATELIMIT_H
@@ -0,0 +1,83 @@
+#include "LogRingBuffer.h"
+
+LogRingBuffer::LogRingBuffer(const size_t capacity) {
+    // rounding up to a power of two, so we can use a bitmask instead of modulo:
+    size = 64;
+    while (size < capacity && size < 0x8000) size <<= 1;
+    mask = size - 1;
+    buffer = new char[size];
+}
+
+LogRingBuffer::~LogRingBuffer() {
+    delete[] buffer;
+}
+
+bool LogRingBuffer::push(const char* data, size_t len, const OverflowPolicy policy, const uint8_t tag) {
+    if (len > size - HEADER_SIZE) len = size - HEADER_SIZE;  // line longer than the whole buffer: truncate
+    const size_t needed = HEADER_SIZE + len;
+
+    const uint32_t h = head.load(std::memory_order_relaxed);
+    while (size - (h - tail.load(std::memory_order_acquire)) < needed) {
+        if (policy != OverflowPolicy::DROP_OLDEST) {
+            if (policy == OverflowPolicy::DROP_NEWEST) droppedLines.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // DROP_OLDEST: skip the oldest record. The consumer may read it at the same time,
+        // so only the one who moves tail successfully "owns" the record.
+        uint32_t t = tail.load(std::memory_order_acquire);
+        if (t == h) break;
+        const uint32_t next = t + HEADER_SIZE + readLength(t);
+        if (tail.compare_exchange_weak(t, next, std::memory_order_acq_rel)) {
+            droppedLines.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    const uint16_t len16 = static_cast<uint16_t>(len);
+    const char header[HEADER_SIZE] = {static_cast<char>(len16 & 0xFF), static_cast<char>(len16 >> 8),
+                                      static_cast<char>(tag)};
+    copyIn(h, header, HEADER_SIZE);
+    copyIn(h + HEADER_SIZE, data, len);
+    head.store(h + needed, std::memory_order_release);
+    return true;
+}
+
+size_t LogRingBuffer::pop(char* dest, const size_t maxLen, uint8_t* tag) {
+    while (true) {
+        uint32_t t = tail.load(std::memory_order_acquire);
+        if (t == head.load(std::memory_order_acquire)) return 0;
+
+        size_t len = readLength(t);
+        if (len > size - HEADER_SIZE) len = size - HEADER_SIZE;  // torn read, CAS below will fail
+        const size_t copyLen = len < maxLen ? len : maxLen;
+        copyOut(t + HEADER_SIZE, dest, copyLen);
+        char tagByte = 0;
+        copyOut(t + HEADER_SIZE - 1, &tagByte, 1);
+
+        // The producer might have dropped this record meanwhile (DROP_OLDEST) -> read again
+        if (tail.compare_exchange_strong(t, t + HEADER_SIZE + len, std::memory_order_acq_rel)) {
+            if (tag != nullptr) *tag = static_cast<uint8_t>(tagByte);
+            return copyLen;
+        }
+    }
+}
+
+void LogRingBuffer::copyIn(const uint32_t pos, const char* src, const size_t len) {
+    const size_t start = pos & mask;
+    const size_t first = len < size - start ? len : size - start;
+    memcpy(buffer + start, src, first);
+    if (first < len) memcpy(buffer, src + first, len - first);
+}
+
+void LogRingBuffer::copyOut(const uint32_t pos, char* dest, const size_t len) const {
+    const size_t start = pos & mask;
+    const size_t first = len < size - start ? len : size - start;
+    memcpy(dest, buffer + start, first);
+    if (first < len) memcpy(dest + first, buffer, len - first);
+}
+
+uint16_t LogRingBuffer::readLength(const uint32_t pos) const {
+    char header[HEADER_SIZE];
+    copyOut(pos, header, HEADER_SIZE);
+    return static_cast<uint16_t>(static_cast<uint8_t>(header[0]) | (static_cast<uint8_t>(header[1]) << 8));
+}
@@ -0,0 +1,58 @@
+#ifndef EZ_LOG_RINGBUFFER_H
+#define EZ_LOG_RINGBUFFER_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "structs.h"
+
+
+/**
+ * Lock-free Ring-Buffer for complete Log-Lines (used by the async mode).
+ *
+ * Exactly one producer (the task owning the EZLog-Instance) and one consumer (the writer-task or flush()).
+ * Each line is stored as a record: 2 bytes length + 1 byte tag (free for the caller) + payload. Positions are free running counters,
+ * so (head - tail) is always the number of used bytes.
+ */
+class LogRingBuffer {
+public:
+    explicit LogRingBuffer(size_t capacity);
+    ~LogRingBuffer();
+
+    LogRingBuffer(const LogRingBuffer&) = delete;
+    LogRingBuffer& operator=(const LogRingBuffer&) = delete;
+
+    /**
+     * Copies a line into the buffer. Returns false, if the line could not be stored.
+     * With OverflowPolicy::BLOCK nothing is dropped - the caller has to wait and retry.
+     */
+    bool push(const char* data, size_t len, OverflowPolicy policy, uint8_t tag = 0);
+
+    /**
+     * Copies the oldest line into dest (truncated to maxLen) and removes it from the buffer.
+     * Returns the number of copied bytes, 0 if the buffer is empty.
+     */
+    size_t pop(char* dest, size_t maxLen, uint8_t* tag = nullptr);
+
+    bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+    size_t used() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+    size_t capacity() const { return size; }
+    uint32_t dropped() const { return droppedLines.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t HEADER_SIZE = 3;
+
+    void copyIn(uint32_t pos, const char* src, size_t len);
+    void copyOut(uint32_t pos, char* dest, size_t len) const;
+    uint16_t readLength(uint32_t pos) const;
+
+    char* buffer;
+    size_t size;   // power of two
+    size_t mask;
+
+    std::atomic<uint32_t> head{0};  // written by producer only
+    std::atomic<uint32_t> tail{0};  // advanced by consumer (and by producer on DROP_OLDEST)
+    std::atomic<uint32_t> droppedLines{0};
+};
+
+
+#endif // EZ_LOG_RINGBUFFER_H
@@ -0,0 +1,89 @@
+#include "LogSink.h"
+
+size_t LogSink::stripColors(char* dest, const size_t destSize, const char* src, const size_t len) {
+    size_t destLen = 0;
+    for (size_t pos = 0; pos < len && destLen < destSize; pos++) {
+        if (src[pos] != '\033') {
+            dest[destLen++] = src[pos];
+            continue;
+        }
+
+        // ESC [ <parameters> <final byte 0x40..0x7E>
+        if (pos + 1 < len && src[pos + 1] == '[') {
+            pos += 2;
+            while (pos < len && (src[pos] < 0x40 || src[pos] > 0x7E)) pos++;
+        }
+    }
+    return destLen;
+}
+
+bool LogSink::canWrite(const size_t len) {
+    const int available = availableForWrite();
+    if (available < 0) return true;
+
+    if (static_cast<size_t>(available) > bufferCapacity) bufferCapacity = available;
+    return available > 0 && static_cast<size_t>(available) >= std::min(len, bufferCapacity);
+}
+
+
+RingSink::RingSink(const size_t capacity, const Loglevel _loglevel, const LogFormat _format)
+    : LogSink(_loglevel, _format), size(capacity > 0 ? capacity : 1) {
+    buffer = new char[size];
+}
+
+RingSink::~RingSink() {
+    delete[] buffer;
+}
+
+void RingSink::write(const char* data, size_t len, Loglevel) {
+    std::lock_guard<std::mutex> guard(mutex);
+
+    // More than fits: only the end is kept
+    if (len > size) {
+        data += len - size;
+        len = size;
+    }
+
+    const size_t end = (start + used) % size;
+    const size_t first = len < size - end ? len : size - end;
+    memcpy(buffer + end, data, first);
+    memcpy(buffer, data + first, len - first);
+
+    used += len;
+    if (used > size) {
+        start = (start + used - size) % size;
+        used = size;
+    }
+}
+
+size_t RingSink::read(char* dest, const size_t maxLen) {
+    std::lock_guard<std::mutex> guard(mutex);
+
+    const size_t len = maxLen < used ? maxLen : used;
+    const size_t first = len < size - start ? len : size - start;
+    memcpy(dest, buffer + start, first);
+    memcpy(dest + first, buffer, len - first);
+
+    start = (start + len) % size;
+    used -= len;
+    return len;
+}
+
+void RingSink::dump(Print& out) {
+    std::lock_guard<std::mutex> guard(mutex);
+
+    const size_t first = used < size - start ? used : size - start;
+    out.write(reinterpret_cast<const uint8_t*>(buffer + start), first);
+    if (first < used) out.write(reinterpret_cast<const uint8_t*>(buffer), used - first);
+}
+
+void RingSink::clear() {
+    std::lock_guard<std::mutex> guard(mutex);
+    start = 0;
+    used = 0;
+}
+
+size_t RingSink::available() {
+    std::lock_guard<std::mutex> guard(mutex);
+    return used;
+}
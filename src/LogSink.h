@@ -0,0 +1,176 @@
+#ifndef EZ_LOG_SINK_H
+#define EZ_LOG_SINK_H
+
+#include <Arduino.h>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include "structs.h"
+#include "LogBinary.h"
+
+
+/**
+ * Output-Target of EZLog (LoggingConfig::sinks). Each sink has its own loglevel and format:
+ *    - loglevel: additional threshold, applied after LoggingConfig::loglevel and the customLoggingElements
+ *    - format:   TEXT (colored), PLAIN (without ANSI-Colors) or BINARY (see LogBinary.h)
+ *
+ * A line is rendered only once per format and then written to all sinks, which want it.
+ * write() is called under the output lock of EZLog (or by the writer task in async mode), never concurrently.
+ * loglevel and format are read by Log::init() / Log::updateConfig(): call it again after changing them.
+ */
+class LogSink {
+public:
+    explicit LogSink(const Loglevel _loglevel = Loglevel::VERBOSE, const LogFormat _format = LogFormat::TEXT)
+        : loglevel(_loglevel), format(_format) {}
+    virtual ~LogSink() = default;
+
+    virtual void write(const char* data, size_t len, Loglevel lineLoglevel) = 0;
+    virtual void flush() {}
+
+    /**
+     * Called regularly by the writer task, f.e. for time based flushing. The writer task is started for it also in
+     * sync mode, if wantsPoll() returns true.
+     */
+    virtual void poll() {}
+    virtual bool wantsPoll() const { return false; }
+
+    /**
+     * Free space of the output buffer (f.e. the TX-FIFO of Serial), -1 = write() doesn't block.
+     * Used for LoggingConfig::backpressurePolicy.
+     */
+    virtual int availableForWrite() { return -1; }
+
+    /**
+     * True, if len bytes can be written without blocking. A line, which is longer than the whole buffer,
+     * is written as soon as the buffer is empty.
+     */
+    bool canWrite(size_t len);
+
+    bool accepts(const Loglevel requestedLoglevel) const { return requestedLoglevel <= loglevel; }
+
+    /**
+     * Lines of this loglevel, which were dropped, because the sink wasn't writable (see LoggingConfig::backpressurePolicy)
+     */
+    uint32_t droppedLines(const Loglevel lineLoglevel) const {
+        return dropped[(int)lineLoglevel].load(std::memory_order_relaxed);
+    }
+    void countDropped(const Loglevel lineLoglevel, const uint32_t lines = 1) {
+        dropped[(int)lineLoglevel].fetch_add(lines, std::memory_order_relaxed);
+        unreported.fetch_add(lines, std::memory_order_relaxed);
+    }
+
+    /**
+     * Copies src without ANSI-Escape-Sequences into dest (truncated to destSize). Returns the new length.
+     */
+    static size_t stripColors(char* dest, size_t destSize, const char* src, size_t len);
+
+    Loglevel loglevel;
+    LogFormat format;
+
+    // Dropped lines, which were not yet reported by a "N lines dropped"-line
+    std::atomic<uint32_t> unreported{0};
+
+    /**
+     * BINARY: the callsites, whose name (CALLSITE record) this sink already got. The name is written in front of the
+     * first line of a callsite, which reaches the sink. Reset, when the stream starts over (Log::updateConfig(),
+     * new file), so it's sent again. Only used under the output lock.
+     */
+    bool callsiteSent(const uint16_t id) const { return (callsitesSent[id / 32] & (1u << (id % 32))) != 0; }
+    void markCallsiteSent(const uint16_t id) { callsitesSent[id / 32] |= 1u << (id % 32); }
+    void resetCallsites() { memset(callsitesSent, 0, sizeof(callsitesSent)); }
+
+private:
+    std::atomic<uint32_t> dropped[5] = {};
+    uint32_t callsitesSent[EZLOG_BINARY_MAX_CALLSITES / 32 + 1] = {};
+    size_t bufferCapacity = 0;      // largest availableForWrite() seen
+};
+
+
+/**
+ * Writes to any Arduino-Print: Serial, Serial1, a connected WiFiClient (network), ...
+ */
+class PrintSink : public LogSink {
+public:
+    explicit PrintSink(Print& _out, const Loglevel _loglevel = Loglevel::VERBOSE,
+                       const LogFormat _format = LogFormat::TEXT) : LogSink(_loglevel, _format), out(_out) {}
+
+    void write(const char* data, const size_t len, Loglevel) override {
+        out.write(reinterpret_cast<const uint8_t*>(data), len);
+    }
+    void flush() override { out.flush(); }
+
+protected:
+    Print& out;
+};
+
+
+/**
+ * PrintSink, which doesn't block, if the TX buffer is full: HardwareSerial, USB-CDC (HWCDC/USBCDC), ...
+ * Needs a Print, which implements availableForWrite(). What happens with a line, which doesn't fit, is set by
+ * LoggingConfig::backpressurePolicy. The default sink (no sinks configured) is a SerialSink for Serial.
+ */
+class SerialSink : public PrintSink {
+public:
+    explicit SerialSink(Print& _serial, const Loglevel _loglevel = Loglevel::VERBOSE,
+                        const LogFormat _format = LogFormat::TEXT) : PrintSink(_serial, _loglevel, _format) {}
+
+    int availableForWrite() override { return out.availableForWrite(); }
+};
+
+
+/**
+ * Passes each line to a function, f.e. to send it as UDP-packet or MQTT-message, or to collect it in a test.
+ */
+class CallbackSink : public LogSink {
+public:
+    explicit CallbackSink(const std::function<void(const char* data, size_t len)>& _callback,
+                          const Loglevel _loglevel = Loglevel::VERBOSE, const LogFormat _format = LogFormat::PLAIN)
+        : LogSink(_loglevel, _format), callback(_callback) {}
+
+    void write(const char* data, const size_t len, Loglevel) override { callback(data, len); }
+
+private:
+    std::function<void(const char* data, size_t len)> callback;
+};
+
+
+/**
+ * Keeps the latest output in RAM. If it's full, the oldest bytes are overwritten.
+ * Useful to log VERBOSE into memory, while only WARN and ERROR go to the (slow) Serial.
+ *
+ * Can be read by the application at any time (own lock).
+ */
+class RingSink : public LogSink {
+public:
+    explicit RingSink(size_t capacity, Loglevel _loglevel = Loglevel::VERBOSE, LogFormat _format = LogFormat::PLAIN);
+    ~RingSink() override;
+
+    RingSink(const RingSink&) = delete;
+    RingSink& operator=(const RingSink&) = delete;
+
+    void write(const char* data, size_t len, Loglevel lineLoglevel) override;
+
+    /**
+     * Copies the oldest bytes into dest and removes them. Returns the number of copied bytes.
+     */
+    size_t read(char* dest, size_t maxLen);
+
+    /**
+     * Writes the whole content to out (f.e. Serial or a File), without removing it
+     */
+    void dump(Print& out);
+
+    void clear();
+    size_t available();
+    size_t capacity() const { return size; }
+
+private:
+    char* buffer;
+    size_t size;
+    size_t start = 0;   // oldest byte
+    size_t used = 0;
+    std::mutex mutex;
+};
+
+
+#endif // EZ_LOG_SINK_H
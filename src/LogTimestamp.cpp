@@ -0,0 +1,115 @@
+#include "LogTimestamp.h"
+#include <sys/time.h>
+#include <time.h>
+
+namespace {
+    constexpr int64_t MICROS_PER_SECOND = 1000000;
+
+    // Times before 2020 mean: not set yet (the ESP32 starts at 1970)
+    constexpr time_t MIN_WALL_CLOCK = 1577836800;
+
+    size_t writeTwoDigits(char* dest, const uint32_t value) {
+        dest[0] = static_cast<char>('0' + value / 10 % 10);
+        dest[1] = static_cast<char>('0' + value % 10);
+        return 2;
+    }
+}
+
+uint32_t LogTimestamp::readCost = 0;
+
+void LogTimestamp::calibrate() {
+    if (readCost != 0) return;
+
+    // Fastest of a few rounds (an interrupt only makes a round slower):
+    constexpr uint32_t reads = 256;
+    int64_t fastest = INT64_MAX;
+    for (uint8_t round = 0; round < 4; round++) {
+        const int64_t start = nowMicros();
+        for (uint32_t i = 0; i < reads; i++) (void)nowMicros();
+        fastest = std::min(fastest, nowMicros() - start);
+    }
+    readCost = std::max<uint32_t>(static_cast<uint32_t>(fastest * 1000 / (reads + 1)), 1);
+}
+
+void LogTimestamp::append(LogLineBuffer& out, const TimestampFormat format) {
+    const int64_t now = nowMicros();
+    int64_t display = now + offset;
+
+    const bool cached = textLen > 0 && format == cachedFormat;
+    if (!cached || display < secondStart || display >= secondStart + MICROS_PER_SECOND) {
+        offset = format == TimestampFormat::WALL_CLOCK ? wallClockOffset(now) : 0;
+        display = now + offset;
+        renderSecond(display, format);
+    }
+
+    const auto fraction = static_cast<uint32_t>(display - secondStart);
+    out.append(text, textLen);
+    out.append('.');
+    if (format == TimestampFormat::UPTIME_MICROS) out.appendNumber(fraction, 6);
+    else out.appendNumber(fraction / 1000, 3);
+}
+
+/**
+ * Renders "HH:MM:SS" of the second, which contains displayMicros. The next second only increments the seconds-field.
+ */
+void LogTimestamp::renderSecond(const int64_t displayMicros, const TimestampFormat format) {
+    const bool nextSecond = textLen > 0 && format == cachedFormat && displayMicros >= secondStart + MICROS_PER_SECOND
+                            && displayMicros < secondStart + 2 * MICROS_PER_SECOND;
+    if (nextSecond && seconds < 59) {
+        secondStart += MICROS_PER_SECOND;
+        seconds++;
+        writeTwoDigits(text + textLen - 2, seconds);
+        return;
+    }
+
+    const int64_t total = displayMicros / MICROS_PER_SECOND;
+    secondStart = total * MICROS_PER_SECOND;
+    cachedFormat = format;
+
+    uint32_t hours, minutes;
+    if (offset != 0) {
+        const auto wallTime = static_cast<time_t>(total);
+        struct tm local;
+        localtime_r(&wallTime, &local);
+        hours = local.tm_hour;
+        minutes = local.tm_min;
+        seconds = local.tm_sec;
+    } else {
+        const auto uptime = static_cast<uint32_t>(total);     // 136 years
+        hours = uptime / 3600;
+        minutes = uptime / 60 % 60;
+        seconds = uptime % 60;
+    }
+
+    // Uptime: more than 99 hours get more digits
+    char hourDigits[10];
+    uint8_t count = 0;
+    do {
+        hourDigits[count++] = static_cast<char>('0' + hours % 10);
+        hours /= 10;
+    } while (hours != 0);
+    if (count < 2) hourDigits[count++] = '0';
+
+    textLen = 0;
+    while (count > 0) text[textLen++] = hourDigits[--count];
+    text[textLen++] = ':';
+    textLen += writeTwoDigits(text + textLen, minutes);
+    text[textLen++] = ':';
+    textLen += writeTwoDigits(text + textLen, seconds);
+}
+
+bool LogTimestamp::wallClockSet() {
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    return now.tv_sec >= MIN_WALL_CLOCK;
+}
+
+/**
+ * Wall clock - uptime in µs, 0 while the time is not set (-> uptime is shown)
+ */
+int64_t LogTimestamp::wallClockOffset(const int64_t nowMicros) {
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    if (now.tv_sec < MIN_WALL_CLOCK) return 0;
+    return static_cast<int64_t>(now.tv_sec) * MICROS_PER_SECOND + now.tv_usec - nowMicros;
+}
@@ -0,0 +1,50 @@
+#ifndef EZ_LOG_TIMESTAMP_H
+#define EZ_LOG_TIMESTAMP_H
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "structs.h"
+#include "LogLineBuffer.h"
+
+
+/**
+ * Timestamp of the text lines (LoggingConfig::timestampFormat), based on the 64 bit µs-timer (esp_timer_get_time()),
+ * so it doesn't wrap after 49 days like millis().
+ *
+ * "HH:MM:SS" is cached and only rendered again, when the second changes - usually only the seconds-digits are
+ * incremented. A line only formats the fraction of the second. Each task owns its own instance (no lock needed).
+ */
+class LogTimestamp {
+public:
+    /** Appends "HH:MM:SS.mmm" (UPTIME, WALL_CLOCK) or "HH:MM:SS.uuuuuu" (UPTIME_MICROS) */
+    void append(LogLineBuffer& out, TimestampFormat format);
+
+    /** µs since the start, does not wrap */
+    static int64_t nowMicros() { return esp_timer_get_time(); }
+
+    /**
+     * Measures the cost of nowMicros() (once, at Log::init()). The duration of a scope is corrected by it,
+     * see EZLog::_scopeDuration().
+     */
+    static void calibrate();
+    static uint32_t readNanos() { return readCost; }
+
+    /** True, if the application has set the time (settimeofday(), SNTP, ...) */
+    static bool wallClockSet();
+
+private:
+    void renderSecond(int64_t displayMicros, TimestampFormat format);
+    static int64_t wallClockOffset(int64_t nowMicros);
+
+    static uint32_t readCost;       // ns per nowMicros()
+
+    TimestampFormat cachedFormat = TimestampFormat::UPTIME;
+    int64_t secondStart = 0;        // begin of the cached second (µs, uptime or wall clock)
+    int64_t offset = 0;             // WALL_CLOCK: wall clock - uptime
+    uint8_t seconds = 0;            // seconds-field of text
+    uint8_t textLen = 0;            // 0 = nothing cached yet
+    char text[16];                  // "HH:MM:SS"
+};
+
+
+#endif // EZ_LOG_TIMESTAMP_H
@@ -0,0 +1,92 @@
+#include "LogTrace.h"
+#include <mutex>
+
+constexpr char LogTrace::BEGIN;
+constexpr char LogTrace::END;
+
+LogTrace::Event* LogTrace::events = nullptr;
+size_t LogTrace::mask = 0;
+std::atomic<uint32_t> LogTrace::writeIndex{0};
+std::atomic<uint32_t> LogTrace::readIndex{0};
+
+void LogTrace::enable(const size_t requestedEvents) {
+    static std::mutex enableMutex;
+    std::lock_guard<std::mutex> guard(enableMutex);
+    if (events != nullptr) return;
+
+    size_t count = 64;
+    while (count < requestedEvents && count < 65536) count <<= 1;
+    mask = count - 1;
+    events = new Event[count];
+}
+
+void LogTrace::clear() {
+    readIndex.store(writeIndex.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+void LogTrace::dump(Print& out) {
+    out.print("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    if (events == nullptr) {
+        out.println("]}");
+        return;
+    }
+
+    const uint32_t end = writeIndex.load(std::memory_order_acquire);
+    uint32_t start = readIndex.load(std::memory_order_acquire);
+    if (end - start > mask + 1) start = end - static_cast<uint32_t>(mask + 1);
+
+    // micros() wraps after ~71 minutes: the timestamps are continued by the (signed) difference to the previous event
+    int64_t timestamp = 0;
+    uint32_t lastTimestampUs = 0;
+    bool first = true;
+    uint32_t tasksSeen[256 / 32] = {};
+    char number[24];
+
+    for (uint32_t index = start; index != end; index++) {
+        const Event& event = events[index & mask];
+        if (event.seq.load(std::memory_order_acquire) != index + 1) continue;
+        const uint32_t timestampUs = event.timestampUs;
+        const LogCallsite* callsite = event.callsite;
+        const uint8_t taskID = event.taskID;
+        const char phase = event.phase;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (event.seq.load(std::memory_order_relaxed) != index + 1) continue;     // overwritten while reading
+
+        timestamp = first ? timestampUs : timestamp + static_cast<int32_t>(timestampUs - lastTimestampUs);
+        lastTimestampUs = timestampUs;
+        tasksSeen[taskID / 32] |= 1u << (taskID % 32);
+
+        out.print(first ? "\n" : ",\n");
+        first = false;
+        out.print("{\"name\":\"");
+        writeEscaped(out, callsite->name);
+        out.print("\",\"cat\":\"EZLog\",\"ph\":\"");
+        out.print(phase);
+        snprintf(number, sizeof(number), "%lld", static_cast<long long>(timestamp));
+        out.print("\",\"ts\":");
+        out.print(number);
+        out.print(",\"pid\":1,\"tid\":");
+        out.print(static_cast<unsigned>(taskID));
+        out.print("}");
+    }
+
+    // Names of the tasks (like the [taskID] of the text output):
+    for (unsigned taskID = 0; taskID < 256; taskID++) {
+        if (!(tasksSeen[taskID / 32] & (1u << (taskID % 32)))) continue;
+        out.print(first ? "\n" : ",\n");
+        first = false;
+        out.print("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":");
+        out.print(taskID);
+        out.print(",\"args\":{\"name\":\"Task ");
+        out.print(taskID);
+        out.print("\"}}");
+    }
+    out.println("\n]}");
+}
+
+void LogTrace::writeEscaped(Print& out, const char* str) {
+    for (; *str != '\0'; str++) {
+        if (*str == '"' || *str == '\\') out.print('\\');
+        out.print(*str);
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef EZ_LOG_TRACE_H
+#define EZ_LOG_TRACE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "LogCallsite.h"
+
+
+/**
+ * Trace-Recording (LoggingConfig::tracing): EZ_LOG()-scopes write begin/end events into a preallocated ring,
+ * which can be dumped as Chrome Trace Event JSON (load it into https://ui.perfetto.dev or chrome://tracing).
+ *
+ * All tasks write into the same ring (lock-free, an atomic index per event). If the ring is full, the oldest
+ * events are overwritten.
+ */
+class LogTrace {
+public:
+    static constexpr char BEGIN = 'B';
+    static constexpr char END = 'E';
+
+    /**
+     * Allocates the ring (rounded up to a power of two). Only the first call allocates.
+     */
+    static void enable(size_t events);
+    static bool isEnabled() { return events != nullptr; }
+
+    static void record(const LogCallsite* callsite, uint8_t taskID, char phase) {
+        const uint32_t index = writeIndex.fetch_add(1, std::memory_order_relaxed);
+        Event& event = events[index & mask];
+        event.seq.store(0, std::memory_order_relaxed);      // invalid while writing
+        std::atomic_thread_fence(std::memory_order_release);
+        event.timestampUs = static_cast<uint32_t>(micros());
+        event.callsite = callsite;
+        event.taskID = taskID;
+        event.phase = phase;
+        event.seq.store(index + 1, std::memory_order_release);
+    }
+
+    /**
+     * Writes the recorded events as JSON ({"traceEvents": [...]}). Recording continues while dumping,
+     * events which are overwritten in the meantime are skipped.
+     */
+    static void dump(Print& out);
+    static void clear();
+
+private:
+    struct Event {
+        std::atomic<uint32_t> seq{0};   // index + 1 of the event, 0 = empty/being written
+        uint32_t timestampUs = 0;
+        const LogCallsite* callsite = nullptr;
+        uint8_t taskID = 0;
+        char phase = 0;
+    };
+
+    static void writeEscaped(Print& out, const char* str);
+
+    static Event* events;
+    static size_t mask;
+    static std::atomic<uint32_t> writeIndex;
+    static std::atomic<uint32_t> readIndex;     // first event after clear()
+};
+
+
+#endif // EZ_LOG_TRACE_H
@@ -3,15 +3,8 @@
 
 #ifndef EZLOG_DISABLE_COMPLETELY
     String _extractClassName(const String &filePath) {
-        const int lastSlash = filePath.lastIndexOf('/');
-        const int lastBackslash = filePath.lastIndexOf('\\');
-        const int start = (lastSlash > lastBackslash) ? lastSlash + 1 : lastBackslash + 1;
-
-        const int lastDot = filePath.lastIndexOf('.');
-        if (lastDot > start) {
-            return filePath.substring(start, lastDot);  // Entfernt den Pfad und die Dateiendung
-        }
-        return filePath.substring(start);  // Falls keine Dateiendung vorhanden ist
+        const LogClassName name = LogClassName::fromFileRuntime(filePath.c_str());
+        return String(name.str, name.len);
     }
 
     String Loggable::extractClassName(const String &filePath) {
@@ -22,6 +15,17 @@
         return _extractClassName(fileName());
     }
 
+    const char* Loggable::internedClassName() const {
+        const char* cls = _internedClassName.load(std::memory_order_acquire);
+        if (cls == nullptr) {
+            const String file = fileName();
+            const LogClassName name = LogClassName::fromFileRuntime(file.c_str());
+            cls = LogCallsite::intern(name.str, name.len);
+            _internedClassName.store(cls, std::memory_order_release);
+        }
+        return cls;
+    }
+
     String AutoLogFree::extractClassName(const String &filePath) {
         return _extractClassName(filePath);
     }
@@ -30,6 +34,10 @@
        enabled = EZLog::start(cls, method);
     }
 
+    AutoLog::AutoLog(const LogCallsite* callsite) {
+        enabled = EZLog::start(callsite);
+    }
+
     AutoLog::~AutoLog() {
         if (enabled) EZLog::end();
     }
@@ -7,6 +7,7 @@
     class AutoLog {
     public:
         AutoLog(const String& cls, const String& method);
+        explicit AutoLog(const LogCallsite* callsite);
         ~AutoLog();
     private:
         bool enabled = false;
@@ -17,6 +18,8 @@
     class Loggable {
     public:
         Loggable() = default;
+        Loggable(const Loggable&) {}
+        Loggable& operator=(const Loggable&) { return *this; }
         virtual ~Loggable() = default;
 
         virtual String fileName() const = 0;  // must be overwritten by child-object
@@ -26,11 +29,25 @@
         // Calculates the Classname from the Filename (__FILE__)
         static String extractClassName(const String& filePath);
 
+        /**
+         * className(), interned at the first call (see LogCallsite::intern()).
+         * Note: calls in the constructor of a base-class will use the fileName() of this base-class.
+         */
+        const char* internedClassName() const;
+
         // Automatic Logging for Instance methods
-        #define EZ_LOG_CLASS() AutoLog _autoLogInstance(className(), __FUNCTION__)
+        #define EZ_LOG_CLASS() \
+            static std::atomic<const LogCallsite*> _ezLogCallsite{nullptr}; \
+            AutoLog _autoLogInstance(LogCallsite::get(_ezLogCallsite, internedClassName(), __FUNCTION__))
+
+        // Automatic Logging for static methods (file like __FILE__, see LogClassName::of())
+        #define EZ_LOG_STATIC(file) \
+            static const LogClassName _ezLogClassName = LogClassName::of(file); \
+            static const LogCallsite* const _ezLogCallsite = LogCallsite::get(_ezLogClassName, __FUNCTION__); \
+            AutoLog _autoLogInstance(_ezLogCallsite)
 
-        // Automatic Logging for static methods
-        #define EZ_LOG_STATIC(file) AutoLog _autoLogInstance(Loggable::extractClassName(file), __FUNCTION__)
+    private:
+        mutable std::atomic<const char*> _internedClassName{nullptr};
     };
 
 
@@ -46,8 +63,15 @@
         bool enabled = false;
     };
 
-    // Makro for Logging in this free functions
-    #define EZ_LOG(fileName) AutoLogFree _freeFunctionLoggerInstance(fileName, __FUNCTION__)
+    /**
+     * Makro for Logging in this free functions.
+     * The callsite is resolved once, so fileName must be the same at each call. From a string literal (f.e. __FILE__ or
+     * "main") the class name is extracted at compile time, from a const char* or String at the first call.
+     */
+    #define EZ_LOG(fileName) \
+        static const LogClassName _ezLogClassName = LogClassName::of(fileName); \
+        static const LogCallsite* const _ezLogCallsite = LogCallsite::get(_ezLogClassName, __FUNCTION__); \
+        AutoLog _freeFunctionLoggerInstance(_ezLogCallsite)
 
 
 
@@ -1,6 +1,10 @@
 #ifndef EZ_LOG_STRUCTS_H
 #define EZ_LOG_STRUCTS_H
 
+#include <Arduino.h>
+#include <vector>
+#include <functional>
+
 /**
  * Log-Levels
  */
@@ -13,16 +17,75 @@ enum class Loglevel {
 };
 
 
+/**
+ * What happens in async mode, if the ring buffer of a task is full
+ */
+enum class OverflowPolicy {
+    DROP_NEWEST = 0,    // the new line is discarded
+    DROP_OLDEST = 1,    // the oldest lines in the buffer are discarded
+    BLOCK = 2           // the logging task waits, until the writer task made room
+};
+
+
+/**
+ * What happens, if a sink can't take a line without blocking (f.e. the TX buffer of Serial is full)
+ */
+enum class BackpressurePolicy {
+    BLOCK = 0,          // waits up to backpressureTimeoutMs, then the line is dropped
+    DROP = 1,           // the line is dropped immediately
+    DROP_BELOW = 2      // lines less severe than backpressureLoglevel are dropped, the others wait like BLOCK
+};
+
+
+/**
+ * Timestamp of the text lines (LoggingConfig::timestampFormat)
+ */
+enum class TimestampFormat {
+    UPTIME = 0,         // "00:01:02.345"
+    UPTIME_MICROS = 1,  // "00:01:02.345678"
+    WALL_CLOCK = 2,     // local time "14:30:02.345", as soon as it's set (settimeofday(), SNTP), before: uptime
+    DELTA = 3           // "+12": milliseconds since the previous line
+};
+
+
+/**
+ * When the memory-info (LoggingConfig::addMemInfo) is queried from the heap
+ */
+enum class MemInfoSampling {
+    EACH_LINE = 0,      // for each line (exact, but 3 heap walks per line)
+    INTERVAL = 1,       // at most every memInfoIntervalMs, the lines in between show the cached values
+    SCOPE_END = 2       // at the end of each EZ_LOG()-scope
+};
+
+
+/**
+ * Output-Format of EZLog
+ */
+enum class LogFormat {
+    TEXT = 0,       // colored text (default)
+    BINARY = 1,     // compact binary records, decoded on the host with tools/ezlog_decode.py
+    PLAIN = 2       // text without ANSI-Colors (f.e. for files or network)
+};
+
+
+class LogSink;
+
+
 /**
  * Custom LoggingElement, which allows overwriting the default Logging-Configuration
  */
 struct LoggingElement {
     String filter;
     Loglevel loglevel = Loglevel::WARN;
+    uint16_t rateLimit = 0;     // lines per second and callsite, 0 = LoggingConfig::rateLimit
     std::vector<LoggingElement> subElements;
 
     LoggingElement(const String& _filter, Loglevel _loglevel) : filter(_filter), loglevel(_loglevel) {};
 
+    LoggingElement(const String& _filter, Loglevel _loglevel, uint16_t _rateLimit) : filter(_filter),
+        loglevel(_loglevel), rateLimit(_rateLimit) {
+    };
+
     LoggingElement(const String& _filter, const std::vector<LoggingElement>& _subElements) : filter(_filter),
         subElements(_subElements) {
     };
@@ -42,6 +105,13 @@ struct LoggingConfig {
     // Adds Information of free/max Memory to each Output:
     bool addMemInfo = false;
 
+    // When the memory-info is queried: EACH_LINE, INTERVAL (at most every memInfoIntervalMs) or SCOPE_END
+    MemInfoSampling memInfoSampling = MemInfoSampling::EACH_LINE;
+    uint32_t memInfoIntervalMs = 1000;
+
+    // Only lines, after which the memory changed (in kB), get the memory-info - as difference to the last printed one
+    bool memInfoOnlyChanges = false;
+
     // Ignores custom LoggingElements and Logs everything:
     bool overrideLogAll = false;
 
@@ -49,17 +119,91 @@ struct LoggingConfig {
     // If a lot of start- and stop-messages without real logging messages are shown, disabling this option can be useful
     bool printStartEndMessages = true;
 
+    // The END-message also shows the time spent in the function itself, without the nested EZ_LOG()-scopes:
+    // "(1250us, self 300us)"
+    bool printSelfTime = false;
+
     // Restarts the ESP, if a Log::error() has been executed.
     // This can make sense on an production environment, if you want to reboot the ESP32, rather than looping endlessly
     bool restartESPonError = false;
 
+    // Output-Format of Serial: TEXT, PLAIN or BINARY (compact records, which are decoded on the host by
+    // tools/ezlog_decode.py). Only used, if no sinks are set.
+    LogFormat outputFormat = LogFormat::TEXT;
+
+    // Terse output for slow links: ANSI-Colors are only sent, when the color actually changes
+    bool terseColors = false;
+
+    // Timestamp of the text lines: UPTIME, UPTIME_MICROS, WALL_CLOCK or DELTA (see TimestampFormat)
+    TimestampFormat timestampFormat = TimestampFormat::UPTIME;
+
+    // Spaces per nesting level of EZ_LOG()-scopes (at most 20 levels are indented)
+    uint8_t indentWidth = 4;
+
+    // Output-Targets (see LogSink.h), each one with its own loglevel and format. Empty = Serial with outputFormat.
+    // The sinks are not copied, they have to live as long as they are configured.
+    std::vector<LogSink*> sinks;
+
+    // What happens, if a sink (f.e. Serial, see SerialSink) can't take a line without blocking. Dropped lines are
+    // counted (Log::droppedLines()) and reported by "N lines dropped", as soon as the sink is writable again.
+    BackpressurePolicy backpressurePolicy = BackpressurePolicy::BLOCK;
+    uint32_t backpressureTimeoutMs = 100;
+    Loglevel backpressureLoglevel = Loglevel::WARN;
+
+    // Asynchronous Logging: Log-Calls only copy the finished line into a ring buffer of the current task.
+    // A low-priority background task writes the buffers to Serial. Use Log::flush() before a reset/abort.
+    bool asyncMode = false;
+
+    // Size of the ring buffer of each task in bytes (async mode only)
+    size_t asyncBufferSize = 4096;
+
+    // What happens if a ring buffer is full (async mode only)
+    OverflowPolicy asyncOverflowPolicy = OverflowPolicy::DROP_NEWEST;
+
+    // FreeRTOS priority and stack size of the writer task (async mode only)
+    UBaseType_t asyncTaskPriority = 1;
+    uint32_t asyncTaskStackSize = 4096;
+
+    // Maximum time in ms until buffered lines are written (async mode only)
+    uint32_t asyncFlushIntervalMs = 20;
+
+    // Aggregates the duration of each EZ_LOG()-scope per callsite (also if start/end-messages are not printed).
+    // See Log::profileReport() / Log::profileReset()
+    bool profiling = false;
+
+    // Compares the free heap/PSRAM at the begin and the end of each EZ_LOG()-scope and accumulates the difference per
+    // callsite. A callsite, which keeps memory in heapLeakThreshold calls in a row, is reported once as possible leak.
+    // See Log::heapReport() / Log::heapReset()
+    bool heapTracking = false;
+    uint16_t heapLeakThreshold = 5;
+
+    // Records begin/end-events of each EZ_LOG()-scope into a ring, which can be exported as Chrome Trace JSON
+    // by Log::traceDump() (for Perfetto / chrome://tracing). Each event needs 16 bytes.
+    bool tracing = false;
+    size_t traceBufferEvents = 1024;
+
+    // Keeps the last lines in RAM, which survives a reset (abort(), watchdog, ...). Log::init() prints the lines of
+    // the previous boot. See LogCrashRing.h for the size (EZLOG_CRASH_RING_RECORDS).
+    bool crashRing = false;
+
+    // Maximum lines per second of each callsite (EZ_LOG()-scope), bursts up to rateLimitBurst lines. Further lines
+    // are dropped before they are formatted (see Log::rateLimitedLines()). 0 = no limit.
+    // Can be overwritten for custom LoggingElements.
+    uint16_t rateLimit = 0;
+    uint16_t rateLimitBurst = 10;
+
+    // Identical consecutive messages of a callsite are only counted and collapsed into "last message repeated N times"
+    // (written before the next other message of the callsite or by Log::flush()). See Log::repeatedLines()
+    bool suppressRepeats = false;
+
     // Custom-Warn/Error Callback-Functions for Warning/Error-Actions.
     // Can be used to show something on a TFT, end the whole process with a while(true); or somehting else
-    std::function<void(int taskID, String msg)> customErrorAction = [](const int taskID, const String& msg) {};
-    std::function<void(int taskID, String msg)> customWarningAction = [](const int taskID, const String& msg) {};
-    std::function<void(int taskID, String msg)> customInfoAction = [](const int taskID, const String& msg) {};
-    std::function<void(int taskID, String msg)> customDebugAction = [](const int taskID, const String& msg) {};
-    std::function<void(int taskID, String msg)> customVerboseAction = [](const int taskID, const String& msg) {};
+    // Not set by default, so no String has to be created for them.
+    std::function<void(int taskID, const String& msg)> customErrorAction = nullptr;
+    std::function<void(int taskID, const String& msg)> customWarningAction = nullptr;
+    std::function<void(int taskID, const String& msg)> customInfoAction = nullptr;
+    std::function<void(int taskID, const String& msg)> customDebugAction = nullptr;
+    std::function<void(int taskID, const String& msg)> customVerboseAction = nullptr;
 
     // Custom LoggingElement-Configurations can be used, to override the default logLevel for matching messages.
     // Example: You can set the default-logLevel to DEBUG, but teh loglevel vor alle Methods from class "xyz" to VERBOSE
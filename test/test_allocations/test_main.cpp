@@ -0,0 +1,165 @@
+/**
+ * The hot paths of EZLog must not allocate (native build, see doc/Benchmarks.md):
+ *    pio test -e native -f test_allocations
+ *
+ * host/HostHeap.cpp counts each operator new. Every body runs once with the same count before it's measured
+ * (instance of the task, callsite, filter decision, ring buffer, full ring buffer), after that the counter must
+ * not move.
+ */
+#include <Arduino.h>
+#include <unity.h>
+#include "EZLog.h"
+#include "HostHeap.h"
+
+namespace {
+    constexpr uint32_t CALLS = 1000;
+
+    LoggingConfig baseConfig() {
+        LoggingConfig config;
+        config.loglevel = Loglevel::DEBUG;
+        config.printStartEndMessages = false;
+        return config;
+    }
+
+    uint64_t allocationsOf(void (*body)(uint32_t count)) {
+        body(CALLS);
+        const uint64_t before = HostHeap::allocations();
+        body(CALLS);
+        return HostHeap::allocations() - before;
+    }
+
+    // Log calls at top level are never filtered, so each body opens a scope:
+    void logFiltered(const uint32_t count) {
+        EZ_LOG("Alloc");
+        for (uint32_t i = 0; i < count; i++) Log::verboseln("this message is filtered out");
+    }
+
+    void logFilteredLazy(const uint32_t count) {
+        EZ_LOG("Alloc");
+        for (uint32_t i = 0; i < count; i++) EZ_VERBOSELN("filtered, not even built: " + String(i));
+    }
+
+    void logEmitted(const uint32_t count) {
+        EZ_LOG("Alloc");
+        for (uint32_t i = 0; i < count; i++) Log::debugln("an emitted message of typical length");
+    }
+
+    void logEmittedParts(const uint32_t count) {
+        EZ_LOG("Alloc");
+        for (uint32_t i = 0; i < count; i++) {
+            Log::debug("first part, ");
+            Log::debugln("second part");
+        }
+    }
+
+    void logEmittedPrintf(const uint32_t count) {
+        EZ_LOG("Alloc");
+        for (uint32_t i = 0; i < count; i++) {
+            Log::debuglnf("value %u of %s: %.2f", static_cast<unsigned>(i), "test", 1.5);
+        }
+    }
+
+    void emptyScope() {
+        EZ_LOG("Alloc");
+    }
+
+    void scopeEnterExit(const uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) emptyScope();
+    }
+
+    void expectNoAllocations(const LoggingConfig& config, void (*body)(uint32_t count)) {
+        Log::updateConfig(config);
+        TEST_ASSERT_EQUAL_UINT64(0, allocationsOf(body));
+    }
+}
+
+void setUp() {
+    Serial.setOutput(nullptr);      // the lines are only counted
+}
+
+void tearDown() {
+    Log::updateConfig(baseConfig());
+}
+
+
+void test_filtered() {
+    expectNoAllocations(baseConfig(), logFiltered);
+}
+
+void test_filtered_lazy() {
+    expectNoAllocations(baseConfig(), logFilteredLazy);
+}
+
+void test_emitted() {
+    expectNoAllocations(baseConfig(), logEmitted);
+}
+
+void test_emitted_parts() {
+    expectNoAllocations(baseConfig(), logEmittedParts);
+}
+
+void test_emitted_printf() {
+    expectNoAllocations(baseConfig(), logEmittedPrintf);
+}
+
+void test_emitted_plain() {
+    LoggingConfig config = baseConfig();
+    config.outputFormat = LogFormat::PLAIN;
+    expectNoAllocations(config, logEmitted);
+}
+
+void test_emitted_binary() {
+    LoggingConfig config = baseConfig();
+    config.outputFormat = LogFormat::BINARY;
+    expectNoAllocations(config, logEmitted);
+}
+
+void test_emitted_async() {
+    LoggingConfig config = baseConfig();
+    config.asyncMode = true;
+    config.asyncOverflowPolicy = OverflowPolicy::BLOCK;
+    expectNoAllocations(config, logEmitted);
+    Log::flush();
+}
+
+void test_scope_filtered() {
+    LoggingConfig config = baseConfig();
+    config.loglevel = Loglevel::ERROR;
+    expectNoAllocations(config, scopeEnterExit);
+}
+
+void test_scope_silent() {
+    expectNoAllocations(baseConfig(), scopeEnterExit);
+}
+
+void test_scope_logged() {
+    LoggingConfig config = baseConfig();
+    config.printStartEndMessages = true;
+    expectNoAllocations(config, scopeEnterExit);
+}
+
+void test_scope_profiled() {
+    LoggingConfig config = baseConfig();
+    config.profiling = true;
+    expectNoAllocations(config, scopeEnterExit);
+}
+
+
+int main() {
+    Log::init(baseConfig());
+
+    UNITY_BEGIN();
+    RUN_TEST(test_filtered);
+    RUN_TEST(test_filtered_lazy);
+    RUN_TEST(test_emitted);
+    RUN_TEST(test_emitted_parts);
+    RUN_TEST(test_emitted_printf);
+    RUN_TEST(test_emitted_plain);
+    RUN_TEST(test_emitted_binary);
+    RUN_TEST(test_emitted_async);
+    RUN_TEST(test_scope_filtered);
+    RUN_TEST(test_scope_silent);
+    RUN_TEST(test_scope_logged);
+    RUN_TEST(test_scope_profiled);
+    return UNITY_END();
+}
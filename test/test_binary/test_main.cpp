@@ -0,0 +1,181 @@
+/**
+ * Binary streams can always be decoded (native build, see doc/Benchmarks.md):
+ *    pio test -e native -f test_binary
+ *
+ * The name of a callsite (CALLSITE record) must be in front of its first LINE record in every sink - also in a sink,
+ * which was added later, and after a line, which the sink dropped.
+ */
+#include <Arduino.h>
+#include <unity.h>
+#include <string>
+#include <vector>
+#include "EZLog.h"
+
+namespace {
+    /**
+     * Collects the stream, availableForWrite() can be set (backpressure)
+     */
+    class StreamSink : public LogSink {
+    public:
+        StreamSink() : LogSink(Loglevel::VERBOSE, LogFormat::BINARY) {}
+
+        void write(const char* data, const size_t len, Loglevel) override { stream.append(data, len); }
+        int availableForWrite() override { return available; }
+
+        std::string stream;
+        int available = 1 << 20;
+    };
+
+    struct Record {
+        uint8_t type;
+        uint32_t id;
+        std::string name;   // CALLSITE
+    };
+
+    size_t readVarint(const std::string& data, size_t pos, uint32_t& value) {
+        value = 0;
+        for (int shift = 0; pos < data.size(); shift += 7) {
+            const auto byte = static_cast<uint8_t>(data[pos++]);
+            value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) break;
+        }
+        return pos;
+    }
+
+    std::vector<Record> parse(const std::string& stream) {
+        std::vector<Record> records;
+        size_t pos = 0;
+        while (pos + 2 < stream.size()) {
+            if (static_cast<uint8_t>(stream[pos]) != LogBinary::SYNC) {
+                pos++;          // passed through text
+                continue;
+            }
+            Record record{static_cast<uint8_t>(stream[pos + 1]), 0, ""};
+            uint32_t payloadLen;
+            const size_t payload = readVarint(stream, pos + 2, payloadLen);
+            const size_t name = readVarint(stream, payload, record.id);
+            if (record.type == LogBinary::TYPE_CALLSITE) record.name = stream.substr(name, payload + payloadLen - name);
+            records.push_back(record);
+            pos = payload + payloadLen;
+        }
+        return records;
+    }
+
+    /**
+     * Every LINE must have the name of its callsite in front of it. Returns the number of CALLSITE records.
+     */
+    int checkNames(const std::string& stream, const char* name) {
+        std::vector<uint32_t> known;
+        int callsites = 0;
+        int lines = 0;
+        for (const Record& record : parse(stream)) {
+            if (record.type == LogBinary::TYPE_CALLSITE) {
+                TEST_ASSERT_EQUAL_STRING(name, record.name.c_str());
+                known.push_back(record.id);
+                callsites++;
+            } else if (record.type == LogBinary::TYPE_LINE) {
+                bool found = false;
+                for (const uint32_t id : known) found |= id == record.id;
+                TEST_ASSERT_TRUE_MESSAGE(found, "LINE without the name of its callsite in front of it");
+                lines++;
+            }
+        }
+        TEST_ASSERT_GREATER_THAN(0, lines);
+        return callsites;
+    }
+
+    LoggingConfig binaryConfig(const std::vector<LogSink*>& sinks) {
+        LoggingConfig config;
+        config.loglevel = Loglevel::DEBUG;
+        config.printStartEndMessages = false;
+        config.outputFormat = LogFormat::BINARY;
+        config.backpressurePolicy = BackpressurePolicy::DROP;
+        config.sinks = sinks;
+        return config;
+    }
+
+    void logLines(const int count) {
+        EZ_LOG("Binary");
+        for (int i = 0; i < count; i++) Log::infoln("a line");
+    }
+
+    void logOtherLines(const int count) {
+        EZ_LOG("Binary");
+        for (int i = 0; i < count; i++) Log::infoln("another line");
+    }
+
+    // Outlive each test (the config still points to them until tearDown())
+    StreamSink first;
+    StreamSink added;
+}
+
+void setUp() {
+    for (StreamSink* sink : {&first, &added}) {
+        sink->stream.clear();
+        sink->available = 1 << 20;
+    }
+}
+
+void tearDown() {
+    Log::updateConfig(LoggingConfig());
+}
+
+
+void test_name_sent_once() {
+    Log::updateConfig(binaryConfig({&first}));
+    logLines(3);
+    Log::flush();
+    TEST_ASSERT_EQUAL_INT(1, checkNames(first.stream, "Binary::logLines"));
+}
+
+void test_sink_added_later_gets_name() {
+    Log::updateConfig(binaryConfig({&first}));
+    logLines(1);
+    Log::updateConfig(binaryConfig({&first, &added}));
+    logLines(1);
+    Log::flush();
+    checkNames(first.stream, "Binary::logLines");
+    TEST_ASSERT_EQUAL_INT(1, checkNames(added.stream, "Binary::logLines"));
+}
+
+void test_name_kept_after_dropped_line() {
+    StreamSink& sink = first;
+    Log::updateConfig(binaryConfig({&sink}));
+    sink.available = 0;
+    logOtherLines(1);           // dropped together with the name
+    TEST_ASSERT_TRUE(sink.stream.empty());
+
+    sink.available = 1 << 20;
+    logOtherLines(1);
+    Log::flush();
+    TEST_ASSERT_EQUAL_INT(1, checkNames(sink.stream, "Binary::logOtherLines"));
+}
+
+void test_async_name_kept_after_dropped_line() {
+    StreamSink& sink = first;
+    LoggingConfig config = binaryConfig({&sink});
+    config.asyncMode = true;
+    Log::updateConfig(config);
+    sink.available = 0;
+    logLines(1);
+    Log::flush();
+    TEST_ASSERT_TRUE(sink.stream.empty());
+
+    sink.available = 1 << 20;
+    logLines(1);
+    Log::flush();
+    TEST_ASSERT_EQUAL_INT(1, checkNames(sink.stream, "Binary::logLines"));
+}
+
+
+int main() {
+    Serial.setOutput(nullptr);
+    Log::init(LoggingConfig());
+
+    UNITY_BEGIN();
+    RUN_TEST(test_name_sent_once);
+    RUN_TEST(test_sink_added_later_gets_name);
+    RUN_TEST(test_name_kept_after_dropped_line);
+    RUN_TEST(test_async_name_kept_after_dropped_line);
+    return UNITY_END();
+}
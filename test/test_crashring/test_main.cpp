@@ -0,0 +1,196 @@
+/**
+ * The crash ring keeps the last lines over a reset (native build, see doc/Benchmarks.md):
+ *    pio test -e native -f test_crashring
+ *
+ * LogCrashRing::simulateReset() keeps the ring, like the no-init RAM of an ESP32 does. The next Log::updateConfig()
+ * must print the lines of the "previous boot", but neither a corrupted record nor a ring with a corrupted header.
+ */
+#include <Arduino.h>
+#include <unity.h>
+#include <cstddef>
+#include <string>
+#include "EZLog.h"
+#include "LogCrashRing.h"
+
+namespace {
+    // The header in front of the records: magic, records, recordSize, bootCount, headerCrc
+    constexpr size_t BOOT_COUNT_OFFSET = 8;
+    constexpr size_t HEADER_SIZE = 16;
+
+    String output;
+    PrintSink errorsOnly(Serial, Loglevel::ERROR);
+
+    class Capture : public Print {
+    public:
+        size_t write(uint8_t c) override {
+            text += static_cast<char>(c);
+            return 1;
+        }
+        std::string text;
+    };
+
+    LoggingConfig crashRingConfig() {
+        LoggingConfig config;
+        config.loglevel = Loglevel::DEBUG;
+        config.printStartEndMessages = false;
+        config.crashRing = true;
+        return config;
+    }
+
+    /**
+     * Resets the device: the next updateConfig() reads the ring. Returns, what it printed.
+     */
+    std::string reboot() {
+        LogCrashRing::simulateReset();
+        output = "";
+        Serial.setCapture(&output);
+        Log::updateConfig(crashRingConfig());
+        Serial.setCapture(nullptr);
+        return output.c_str();
+    }
+
+    uint8_t* find(const char* text) {
+        const std::string ring(reinterpret_cast<const char*>(LogCrashRing::memory()), LogCrashRing::memorySize());
+        const size_t pos = ring.find(text);
+        return pos == std::string::npos ? nullptr : LogCrashRing::memory() + pos;
+    }
+
+    /**
+     * Start of the record, which contains text (its first field is seq)
+     */
+    uint8_t* recordOf(const uint8_t* text) {
+        const size_t pos = static_cast<size_t>(text - LogCrashRing::memory()) - HEADER_SIZE;
+        return LogCrashRing::memory() + HEADER_SIZE + pos - pos % EZLOG_CRASH_RING_RECORD_SIZE;
+    }
+
+    bool contains(const std::string& text, const char* part) {
+        return text.find(part) != std::string::npos;
+    }
+}
+
+void setUp() {
+    // Power-on: the memory contains garbage
+    LogCrashRing::memory()[0] ^= 0xFF;
+    reboot();
+}
+
+void tearDown() {}
+
+
+void test_records_survive_reset() {
+    {
+        EZ_LOG("Crash");
+        Log::infoln("first before the reset");
+        Log::warnln("second before the reset");
+        Log::errorln("third before the reset");
+    }
+
+    const std::string dump = reboot();
+    TEST_ASSERT_TRUE_MESSAGE(contains(dump, "EZLog: last 3 lines before the reset"), dump.c_str());
+    const size_t first = dump.find("[INFO]    Crash::test_records_survive_reset: first before the reset");
+    const size_t second = dump.find("[WARN]    Crash::test_records_survive_reset: second before the reset");
+    const size_t third = dump.find("[ERROR]   Crash::test_records_survive_reset: third before the reset");
+    TEST_ASSERT_TRUE_MESSAGE(first != std::string::npos && first < second && second < third &&
+                             third != std::string::npos, dump.c_str());
+    TEST_ASSERT_TRUE(contains(dump, "EZLog: end of the previous boot"));
+}
+
+void test_records_survive_second_reset() {
+    {
+        EZ_LOG("Crash");
+        Log::infoln("older boot");
+    }
+    reboot();
+    {
+        EZ_LOG("Crash");
+        Log::infoln("newer boot");
+    }
+
+    // Kept until they are overwritten, the dump of the previous boot contains both:
+    const std::string dump = reboot();
+    TEST_ASSERT_TRUE_MESSAGE(contains(dump, "older boot") && contains(dump, "newer boot"), dump.c_str());
+}
+
+void test_corrupted_record_is_skipped() {
+    {
+        EZ_LOG("Crash");
+        Log::infoln("intact before");
+        Log::infoln("corrupted by the reset");
+        Log::infoln("intact after");
+    }
+    uint8_t* text = find("corrupted by the reset");
+    TEST_ASSERT_NOT_NULL(text);
+    text[0] = 'C';
+
+    const std::string dump = reboot();
+    TEST_ASSERT_TRUE_MESSAGE(contains(dump, "EZLog: last 2 lines before the reset"), dump.c_str());
+    TEST_ASSERT_TRUE(contains(dump, "intact before"));
+    TEST_ASSERT_TRUE(contains(dump, "intact after"));
+    TEST_ASSERT_FALSE(contains(dump, "orrupted by the reset"));
+}
+
+void test_interrupted_record_is_skipped() {
+    {
+        EZ_LOG("Crash");
+        Log::infoln("intact");
+        Log::infoln("interrupted by the reset");
+    }
+    // seq is written last, the record was not finished:
+    uint8_t* text = find("interrupted by the reset");
+    TEST_ASSERT_NOT_NULL(text);
+    memset(recordOf(text), 0, sizeof(uint32_t));
+
+    const std::string dump = reboot();
+    TEST_ASSERT_TRUE_MESSAGE(contains(dump, "EZLog: last 1 lines before the reset"), dump.c_str());
+    TEST_ASSERT_TRUE(contains(dump, "intact"));
+    TEST_ASSERT_FALSE(contains(dump, "interrupted by the reset"));
+}
+
+void test_bad_header_crc_is_rejected() {
+    {
+        EZ_LOG("Crash");
+        Log::infoln("behind a corrupted header");
+    }
+    LogCrashRing::memory()[BOOT_COUNT_OFFSET] ^= 0x01;
+
+    const std::string dump = reboot();
+    TEST_ASSERT_FALSE_MESSAGE(contains(dump, "before the reset"), dump.c_str());
+
+    // The ring was cleared, it doesn't even show the lines as lines of this boot:
+    Capture current;
+    Log::crashDump(current);
+    TEST_ASSERT_FALSE(contains(current.text, "behind a corrupted header"));
+}
+
+/**
+ * Lines, which no sink takes, are still recorded - also by the lazy methods, which ask isEnabled() first
+ */
+void test_records_lines_without_sink() {
+    LoggingConfig config = crashRingConfig();
+    config.sinks = {&errorsOnly};
+    Log::updateConfig(config);
+    {
+        EZ_LOG("Crash");
+        TEST_ASSERT_TRUE(Log::isEnabled(Loglevel::DEBUG));
+        TEST_ASSERT_FALSE(Log::isEnabled(Loglevel::VERBOSE));
+        Log::debuglnf("only in the ring #%d", 1);
+    }
+
+    const std::string dump = reboot();
+    TEST_ASSERT_TRUE_MESSAGE(contains(dump, "only in the ring #1"), dump.c_str());
+}
+
+
+int main() {
+    Log::init(crashRingConfig());
+    Serial.setOutput(nullptr);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_records_survive_reset);
+    RUN_TEST(test_records_survive_second_reset);
+    RUN_TEST(test_corrupted_record_is_skipped);
+    RUN_TEST(test_interrupted_record_is_skipped);
+    RUN_TEST(test_bad_header_crc_is_rejected);
+    RUN_TEST(test_records_lines_without_sink);
+    return UNITY_END();
+}
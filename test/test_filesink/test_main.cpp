@@ -0,0 +1,224 @@
+/**
+ * FileSink after a power loss (native build, see doc/Benchmarks.md):
+ *    pio test -e native -f test_filesink
+ *
+ * The file ends with an incomplete line (TEXT) or record (BINARY). The sink must cut it off, before it continues
+ * the file, so the next line starts clean. The files are written into a temporary directory (host/FS.h).
+ */
+#include <Arduino.h>
+#include <unity.h>
+#include <string>
+#include <unistd.h>
+#include "EZLog.h"
+#include "LogBinary.h"
+#include "LogFileSink.h"
+
+namespace {
+    const char* const PATH = "/ezlog.log";
+
+    char directory[32];
+    fs::FS* filesystem = nullptr;
+
+    LoggingConfig baseConfig() {
+        LoggingConfig config;
+        config.loglevel = Loglevel::DEBUG;
+        config.printStartEndMessages = false;
+        return config;
+    }
+
+    void writeFile(const char* path, const std::string& content) {
+        fs::File file = filesystem->open(path, FILE_WRITE);
+        file.write(reinterpret_cast<const uint8_t*>(content.data()), content.size());
+        file.close();
+    }
+
+    std::string readFile(const char* path) {
+        std::string content;
+        fs::File file = filesystem->open(path, FILE_READ);
+        uint8_t chunk[256];
+        size_t read;
+        while ((read = file.read(chunk, sizeof(chunk))) > 0) content.append(reinterpret_cast<char*>(chunk), read);
+        return content;
+    }
+
+    /**
+     * Logs one line through the sink (the first write() opens the file and recovers it)
+     */
+    void logLine(FileSink& sink) {
+        LoggingConfig config = baseConfig();
+        config.sinks = {&sink};
+        Log::updateConfig(config);
+        {
+            EZ_LOG("Recovery");
+            Log::infoln("after the power loss");
+        }
+        Log::flush();
+        Log::updateConfig(baseConfig());
+        sink.close();
+    }
+
+    std::string record(const uint8_t* data, const size_t len) {
+        return std::string(reinterpret_cast<const char*>(data), len);
+    }
+}
+
+void setUp() {
+    strcpy(directory, "/tmp/ezlog-test-XXXXXX");
+    TEST_ASSERT_NOT_NULL(mkdtemp(directory));
+    filesystem = new fs::FS(directory);
+}
+
+void tearDown() {
+    for (const char* path : {PATH, "/ezlog.log.tmp", "/ezlog.log.1", "/ezlog.log.2"}) filesystem->remove(path);
+    delete filesystem;
+    filesystem = nullptr;
+    rmdir(directory);
+}
+
+
+void test_text_cuts_incomplete_line() {
+    const std::string complete = "[1] 00:00:01.000 [INFO]    first line\n[1] 00:00:01.001 [INFO]    second line\n";
+    const std::string truncated = "[1] 00:00:01.002 [INFO]    third li";
+    writeFile(PATH, complete + truncated);
+
+    FileSink sink(*filesystem, PATH, 64 * 1024, 1, Loglevel::VERBOSE, LogFormat::PLAIN);
+    logLine(sink);
+
+    const std::string content = readFile(PATH);
+    TEST_ASSERT_EQUAL_UINT32(truncated.size(), sink.recoveredBytes());
+    TEST_ASSERT_EQUAL_STRING(complete.c_str(), content.substr(0, complete.size()).c_str());
+    TEST_ASSERT_TRUE(content.compare(complete.size(), 3, "[1]") == 0);   // the new line starts clean
+    TEST_ASSERT_TRUE(content.find("after the power loss\n") != std::string::npos);
+    TEST_ASSERT_TRUE(content.find("third li") == std::string::npos);
+}
+
+void test_text_complete_file_is_kept() {
+    const std::string complete = "[1] 00:00:01.000 [INFO]    first line\n";
+    writeFile(PATH, complete);
+
+    FileSink sink(*filesystem, PATH, 64 * 1024, 1, Loglevel::VERBOSE, LogFormat::PLAIN);
+    logLine(sink);
+
+    TEST_ASSERT_EQUAL_UINT32(0, sink.recoveredBytes());
+    TEST_ASSERT_EQUAL_STRING(complete.c_str(), readFile(PATH).substr(0, complete.size()).c_str());
+}
+
+void test_binary_cuts_incomplete_record() {
+    static const char name[] = "Sensor::read";
+    uint8_t buffer[EZLOG_MAX_LINE_LENGTH];
+
+    const std::string callsite = record(buffer, LogBinary::encodeCallsite(buffer, sizeof(buffer), 1, name,
+                                                                          strlen(name)));
+    LogBinaryLine line;
+    line.callsiteId = 1;
+    line.taskID = 1;
+    line.loglevel = Loglevel::INFO;
+    const std::string first = record(buffer, LogBinary::encodeLine(buffer, sizeof(buffer), line, "first", 5));
+    const std::string second = record(buffer, LogBinary::encodeLine(buffer, sizeof(buffer), line, "second", 6));
+    const std::string passedThrough = "boot message\n";
+
+    // The last record lost its end (header and a part of the payload were written):
+    const std::string complete = callsite + first + passedThrough;
+    const std::string truncated = second.substr(0, second.size() - 3);
+    writeFile(PATH, complete + truncated);
+
+    FileSink sink(*filesystem, PATH, 64 * 1024, 1, Loglevel::VERBOSE, LogFormat::BINARY);
+    logLine(sink);
+
+    const std::string content = readFile(PATH);
+    TEST_ASSERT_EQUAL_UINT32(truncated.size(), sink.recoveredBytes());
+    TEST_ASSERT_TRUE(content.compare(0, complete.size(), complete) == 0);
+    TEST_ASSERT_TRUE(content.size() > complete.size());
+    TEST_ASSERT_EQUAL(LogBinary::SYNC, static_cast<uint8_t>(content[complete.size()]));   // next record starts clean
+    TEST_ASSERT_TRUE(content.find("after the power loss") != std::string::npos);
+}
+
+void test_binary_cuts_incomplete_header() {
+    uint8_t buffer[EZLOG_MAX_LINE_LENGTH];
+    LogBinaryLine line;
+    line.taskID = 1;
+    const std::string complete = record(buffer, LogBinary::encodeLine(buffer, sizeof(buffer), line, "first", 5));
+    const std::string truncated = complete.substr(0, 2);      // SYNC and type, the length is missing
+    writeFile(PATH, complete + truncated);
+
+    FileSink sink(*filesystem, PATH, 64 * 1024, 1, Loglevel::VERBOSE, LogFormat::BINARY);
+    logLine(sink);
+
+    const std::string content = readFile(PATH);
+    TEST_ASSERT_EQUAL_UINT32(truncated.size(), sink.recoveredBytes());
+    TEST_ASSERT_TRUE(content.compare(0, complete.size(), complete) == 0);
+    TEST_ASSERT_EQUAL(LogBinary::SYNC, static_cast<uint8_t>(content[complete.size()]));
+}
+
+void test_binary_rotated_files_have_names() {
+    FileSink sink(*filesystem, PATH, 256, 3, Loglevel::VERBOSE, LogFormat::BINARY);
+    LoggingConfig config = baseConfig();
+    config.sinks = {&sink};
+    Log::updateConfig(config);
+    {
+        EZ_LOG("Rotation");
+        for (int i = 0; i < 40; i++) Log::infoln("a line, which fills the file");
+    }
+    Log::flush();
+    Log::updateConfig(baseConfig());
+    sink.close();
+
+    // Each file starts with the name of the callsite (the lines of one callsite only):
+    for (const char* path : {PATH, "/ezlog.log.1", "/ezlog.log.2"}) {
+        const std::string content = readFile(path);
+        TEST_ASSERT_TRUE_MESSAGE(content.size() > 2, path);
+        TEST_ASSERT_EQUAL(LogBinary::SYNC, static_cast<uint8_t>(content[0]));
+        TEST_ASSERT_EQUAL_MESSAGE(LogBinary::TYPE_CALLSITE, static_cast<uint8_t>(content[1]), path);
+        TEST_ASSERT_TRUE(content.find("Rotation::test_binary_rotated_files_have_names") != std::string::npos);
+    }
+}
+
+void test_sync_buffer_written_after_interval() {
+    FileSink sink(*filesystem, PATH, 64 * 1024, 1, Loglevel::VERBOSE, LogFormat::PLAIN);
+    sink.flushIntervalMs = 20;
+    LoggingConfig config = baseConfig();
+    config.sinks = {&sink};
+    Log::updateConfig(config);
+    {
+        EZ_LOG("Quiet");
+        Log::infoln("last line before a quiet period");
+    }
+
+    // No further line and no Log::flush(): the writer task writes the buffer
+    std::string content;
+    for (int waited = 0; waited < 2000 && content.empty(); waited += 10) {
+        delay(10);
+        content = readFile(PATH);
+    }
+    Log::updateConfig(baseConfig());
+    sink.close();
+    TEST_ASSERT_TRUE(content.find("last line before a quiet period") != std::string::npos);
+}
+
+void test_power_loss_during_recovery() {
+    // The original was already removed, the recovered copy not yet renamed:
+    const std::string complete = "[1] 00:00:01.000 [INFO]    first line\n";
+    writeFile("/ezlog.log.tmp", complete);
+
+    FileSink sink(*filesystem, PATH, 64 * 1024, 1, Loglevel::VERBOSE, LogFormat::PLAIN);
+    logLine(sink);
+
+    TEST_ASSERT_FALSE(filesystem->exists("/ezlog.log.tmp"));
+    TEST_ASSERT_EQUAL_STRING(complete.c_str(), readFile(PATH).substr(0, complete.size()).c_str());
+}
+
+
+int main() {
+    Log::init(baseConfig());
+    Serial.setOutput(nullptr);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_text_cuts_incomplete_line);
+    RUN_TEST(test_text_complete_file_is_kept);
+    RUN_TEST(test_binary_cuts_incomplete_record);
+    RUN_TEST(test_binary_cuts_incomplete_header);
+    RUN_TEST(test_binary_rotated_files_have_names);
+    RUN_TEST(test_sync_buffer_written_after_interval);
+    RUN_TEST(test_power_loss_during_recovery);
+    return UNITY_END();
+}
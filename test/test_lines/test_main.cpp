@@ -0,0 +1,303 @@
+/**
+ * Each line reaches the output whole (native build, see doc/Benchmarks.md):
+ *    pio test -e native -f test_lines
+ *
+ * A line is assembled in the buffers of its task and committed with one write under the output lock (sync mode)
+ * or into the ring buffer of its task (async mode). The output of a scope must be the same in both modes, and the
+ * parts of partial lines (Log::debug() without ln) of several tasks must never interleave.
+ */
+#include <Arduino.h>
+#include <unity.h>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include "EZLog.h"
+
+namespace {
+    constexpr int TASKS = 6;
+    constexpr int LINES_PER_TASK = 2000;
+
+    String output;
+
+    LoggingConfig baseConfig() {
+        LoggingConfig config;
+        config.loglevel = Loglevel::VERBOSE;
+        config.outputFormat = LogFormat::PLAIN;
+        return config;
+    }
+
+    /**
+     * Replaces the timestamps and the durations, which vary per run
+     */
+    std::string normalized(const std::string& text) {
+        std::string result;
+        for (size_t i = 0; i < text.size(); i++) {
+            unsigned h, m, s, ms;
+            int len = 0;
+            if (sscanf(text.c_str() + i, "%2u:%2u:%2u.%3u%n", &h, &m, &s, &ms, &len) == 4 && len == 12) {
+                result += "T";
+                i += len - 1;
+            } else if (text.compare(i, 2, " (") == 0 && text.find("s)", i) != std::string::npos &&
+                       isdigit(static_cast<unsigned char>(text[i + 2]))) {
+                result += " (D)";
+                i = text.find("s)", i) + 1;
+            } else {
+                result += text[i];
+            }
+        }
+        return result;
+    }
+
+    std::string capture(void (*body)()) {
+        output = "";
+        Serial.setCapture(&output);
+        body();
+        Log::flush();
+        Serial.setCapture(nullptr);
+        return normalized(output.c_str());
+    }
+
+    void inner() {
+        EZ_LOG("Lines");
+        Log::debugln("inner line");
+        Log::verboseln("verbose");
+    }
+
+    void scope() {
+        EZ_LOG("Lines");
+        Log::infoln("Hello " + String(42));
+        Log::debug("part1 ");
+        Log::debugln("part2");
+        Log::warnln("multi\nline\nmsg");
+        inner();
+        Log::errorln("");
+    }
+
+    const char* const GOLDEN =
+        "[1] T [DEBUG]    ++ Lines::scope - [START]\n"
+        "[1] T [INFO]        Lines::scope: Hello 42\n"
+        "[1] T [DEBUG]       Lines::scope: part1 part2\n"
+        "[1] T [WARN]        Lines::scope: multi\n"
+        "[1] T [WARN]        Lines::scope: line\n"
+        "[1] T [WARN]        Lines::scope: msg\n"
+        "[1] T [DEBUG]        ++ Lines::inner - [START]\n"
+        "[1] T [DEBUG]           Lines::inner: inner line\n"
+        "[1] T [VERBOSE]         Lines::inner: verbose\n"
+        "[1] T [DEBUG]        -- Lines::inner - [END]  (D)\n"
+        "[1] T [ERROR]       Lines::scope: \n"
+        "[1] T [DEBUG]    -- Lines::scope - [END]  (D)\n";
+
+    void formatted() {
+        EZ_LOG("Lines");
+        Log::infolnf("value %d of %s", 42, "formatted");
+    }
+
+    void repeated() {
+        EZ_LOG("Lines");
+        Log::debugln("same");
+        Log::debugln("same");
+        Log::debug("part1 ");
+        Log::debugln("part2");
+    }
+
+    void runtimeNames() {
+        {
+            const String file = String("/src/") + "FromString.cpp";
+            EZ_LOG(file);
+            Log::infoln("string");
+        }
+        {
+            const char* path = "C:\\sketch\\FromPointer.ino";
+            EZ_LOG(path);
+            Log::infoln("pointer");
+        }
+    }
+
+    void logLong(const std::string& msg) {
+        EZ_LOG("Lines");
+        Log::infoln(msg.c_str());
+    }
+
+    /**
+     * True, if every escape sequence of the line is complete ("ESC [" ... final byte)
+     */
+    bool sequencesComplete(const std::string& line) {
+        for (size_t pos = line.find('\033'); pos != std::string::npos; pos = line.find('\033', pos + 1)) {
+            if (pos + 1 >= line.size() || line[pos + 1] != '[') return false;
+            size_t end = pos + 2;
+            while (end < line.size() && line[end] >= 0x20 && line[end] <= 0x3F) end++;
+            if (end >= line.size() || line[end] < 0x40 || line[end] > 0x7E) return false;
+        }
+        return true;
+    }
+
+    void logParts(const int task, const int line) {
+        EZ_LOG("Worker");
+        char part[32];
+        snprintf(part, sizeof(part), "<%d:a ", task);
+        Log::debug(part);
+        snprintf(part, sizeof(part), "%d:b ", task);
+        Log::debug(part);
+        snprintf(part, sizeof(part), "%d:c#%d>", task, line);
+        Log::debugln(part);
+    }
+
+    /**
+     * Every line must be a START/END line or hold the three parts of exactly one task
+     */
+    void checkLines(const std::string& text) {
+        int count[TASKS + 1] = {};
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t end = text.find('\n', pos);
+            if (end == std::string::npos) end = text.size();
+            const std::string line = text.substr(pos, end - pos);
+            pos = end + 1;
+            if (line.find("[START]") != std::string::npos || line.find("[END]") != std::string::npos) continue;
+
+            const size_t start = line.find('<');
+            int task = 0, b = 0, c = 0, number = 0, len = 0;
+            const bool ok = start != std::string::npos &&
+                            sscanf(line.c_str() + start, "<%d:a %d:b %d:c#%d>%n", &task, &b, &c, &number, &len) == 4 &&
+                            task == b && task == c && task >= 1 && task <= TASKS &&
+                            start + len == line.size() && line.find('<', start + 1) == std::string::npos;
+            TEST_ASSERT_TRUE_MESSAGE(ok, line.c_str());
+            TEST_ASSERT_EQUAL_INT(count[task], number);     // in order per task, nothing lost
+            count[task]++;
+        }
+        for (int task = 1; task <= TASKS; task++) TEST_ASSERT_EQUAL_INT(LINES_PER_TASK, count[task]);
+    }
+
+    std::string logFromTasks() {
+        output = "";
+        Serial.setCapture(&output);
+        std::vector<std::thread> tasks;
+        for (int task = 1; task <= TASKS; task++) {
+            tasks.emplace_back([task]() {
+                for (int line = 0; line < LINES_PER_TASK; line++) logParts(task, line);
+            });
+        }
+        for (std::thread& task : tasks) task.join();
+        Log::flush();
+        Serial.setCapture(nullptr);
+        return output.c_str();
+    }
+}
+
+void setUp() {
+    Log::updateConfig(baseConfig());
+}
+
+void tearDown() {}
+
+
+void test_golden_sync() {
+    TEST_ASSERT_EQUAL_STRING(GOLDEN, capture(scope).c_str());
+}
+
+void test_golden_async() {
+    LoggingConfig config = baseConfig();
+    config.asyncMode = true;
+    Log::updateConfig(config);
+    TEST_ASSERT_EQUAL_STRING(GOLDEN, capture(scope).c_str());
+}
+
+void test_partial_lines_sync() {
+    LoggingConfig config = baseConfig();
+    config.loglevel = Loglevel::DEBUG;
+    Log::updateConfig(config);
+    checkLines(logFromTasks());
+}
+
+void test_partial_lines_async() {
+    LoggingConfig config = baseConfig();
+    config.loglevel = Loglevel::DEBUG;
+    config.asyncMode = true;
+    config.asyncOverflowPolicy = OverflowPolicy::BLOCK;
+    Log::updateConfig(config);
+    checkLines(logFromTasks());
+}
+
+/**
+ * A custom action formats its own line behind the text of the outer call, which must stay intact
+ */
+void test_logf_from_custom_action() {
+    LoggingConfig config = baseConfig();
+    config.printStartEndMessages = false;
+    config.customInfoAction = [](int, const String& msg) { Log::debuglnf("action got '%s'", msg.c_str()); };
+    Log::updateConfig(config);
+    TEST_ASSERT_EQUAL_STRING("[1] T [DEBUG]       Lines::formatted: action got 'value 42 of formatted'\n"
+                             "[1] T [INFO]        Lines::formatted: value 42 of formatted\n",
+                             capture(formatted).c_str());
+}
+
+/**
+ * The notice is written in front of a line, whose first part is already pending - and doesn't lose that part
+ */
+void test_notice_before_partial_line() {
+    LoggingConfig config = baseConfig();
+    config.printStartEndMessages = false;
+    config.suppressRepeats = true;
+    Log::updateConfig(config);
+    TEST_ASSERT_EQUAL_STRING("[1] T [DEBUG]       Lines::repeated: same\n"
+                             "[1] T [DEBUG]       Lines::repeated: last message repeated 1 time\n"
+                             "[1] T [DEBUG]       Lines::repeated: part1 part2\n",
+                             capture(repeated).c_str());
+}
+
+/**
+ * A truncated line ends with the reset of its colors - and is never cut inside an escape sequence
+ */
+void test_truncated_line_resets_colors() {
+    LoggingConfig config = baseConfig();
+    config.outputFormat = LogFormat::TEXT;
+    config.printStartEndMessages = false;
+    Log::updateConfig(config);
+
+    // Each padding moves the cut to another char of the (9 chars long) color code:
+    for (int padding = 0; padding < 9; padding++) {
+        std::string msg(padding, '.');
+        while (msg.size() < EZLOG_MAX_LINE_LENGTH) msg += "\033[1;32mab";
+
+        output = "";
+        Serial.setCapture(&output);
+        logLong(msg);
+        Serial.setCapture(nullptr);
+
+        const std::string line = output.c_str();
+        TEST_ASSERT_TRUE(line.size() <= EZLOG_MAX_LINE_LENGTH && line.size() > EZLOG_MAX_LINE_LENGTH - 16);
+        TEST_ASSERT_TRUE_MESSAGE(line.size() >= 5 && line.compare(line.size() - 5, 5, "\033[0m\n") == 0,
+                                 line.c_str());
+        TEST_ASSERT_TRUE_MESSAGE(sequencesComplete(line), line.c_str());
+    }
+}
+
+/**
+ * EZ_LOG() also takes a file name, which is no string literal
+ */
+void test_runtime_file_names() {
+    LoggingConfig config = baseConfig();
+    config.printStartEndMessages = false;
+    Log::updateConfig(config);
+    TEST_ASSERT_EQUAL_STRING("[1] T [INFO]        FromString::runtimeNames: string\n"
+                             "[1] T [INFO]        FromPointer::runtimeNames: pointer\n",
+                             capture(runtimeNames).c_str());
+}
+
+
+int main() {
+    Log::init(baseConfig());
+    Serial.setOutput(nullptr);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_golden_sync);
+    RUN_TEST(test_golden_async);
+    RUN_TEST(test_partial_lines_sync);
+    RUN_TEST(test_partial_lines_async);
+    RUN_TEST(test_logf_from_custom_action);
+    RUN_TEST(test_notice_before_partial_line);
+    RUN_TEST(test_truncated_line_resets_colors);
+    RUN_TEST(test_runtime_file_names);
+    return UNITY_END();
+}
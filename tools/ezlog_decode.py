@@ -0,0 +1,285 @@
+#!/usr/bin/env python3
+"""
+EZLog host decoder for the binary output format (LoggingConfig::outputFormat = LogFormat::BINARY).
+
+Rebuilds the exact colored output, which EZLog prints in TEXT mode. See src/LogBinary.h for the record format.
+Everything outside of binary records (boot messages, backtraces, ...) is passed through unchanged.
+
+Usage:
+    python3 tools/ezlog_decode.py capture.bin             # decode a file
+    python3 tools/ezlog_decode.py --port /dev/ttyUSB0     # decode live from a serial port (needs pyserial)
+    python3 tools/ezlog_decode.py --indent 2 capture.bin  # LoggingConfig::indentWidth = 2
+    pio device monitor --raw | python3 tools/ezlog_decode.py
+"""
+
+import argparse
+import sys
+
+SYNC = 0xE7
+TYPE_CALLSITE = 0x01
+TYPE_LINE = 0x02
+
+FLAG_START = 0x08
+FLAG_END = 0x10
+FLAG_MEMINFO = 0x20
+FLAG_PARTIAL = 0x40
+FLAG_MICROS = 0x80
+
+MAX_PAYLOAD = 4096
+
+# Same values as in EZLog.cpp
+COLORS = {
+    "RESET": "\033[0m",
+    "RED": "\033[1;31m",
+    "GREEN": "\033[1;32m",
+    "YELLOW": "\033[1;33m",
+    "WHITE": "\033[1;37m",
+    "CYAN": "\033[1;36m",
+    "BLUE": "\033[1;34m",
+    "BRIGHT_MAGENTA": "\033[1;95m",
+    "BRIGHT_YELLOW": "\033[1;93m",
+    "BRIGHT_BLACK": "\033[1;90m",
+    "BG_CYAN": "\033[1;46m",
+    "BG_YELLOW": "\033[1;43m",
+    "BG_BRIGHT_BLACK": "\033[1;100m",
+}
+
+LOGLEVEL_STRINGS = ["[ERROR]   ", "[WARN]    ", "[INFO]    ", "[DEBUG]   ", "[VERBOSE] "]
+
+
+class Renderer:
+    """Renders a decoded line exactly like EZLog::_msg()"""
+
+    def __init__(self, colors=True, indent=4):
+        c = COLORS if colors else {k: "" for k in COLORS}
+        self.c = c
+        self.indent = indent
+        self.task_colors = [c["WHITE"], c["BLUE"], c["YELLOW"], c["GREEN"]]
+        self.task_bg_colors = [c["RESET"], c["BG_BRIGHT_BLACK"], c["BG_CYAN"], c["BG_YELLOW"]]
+        self.prefix_colors = [c["RED"], c["BRIGHT_MAGENTA"], c["GREEN"], c["WHITE"], c["BRIGHT_BLACK"]]
+        self.text_colors = [c["RED"], c["RED"], c["GREEN"], c["WHITE"], c["BRIGHT_BLACK"]]
+
+    def bg_color(self, task_id):
+        if task_id == 1:
+            return self.task_bg_colors[0]
+        num_colors = len(self.task_bg_colors) - 1
+        return self.task_bg_colors[((task_id - 2) % num_colors) + 1]
+
+    @staticmethod
+    def timestamp(millis):
+        return "%02d:%02d:%02d.%03d" % (millis // 3600000, (millis % 3600000) // 60000,
+                                        (millis % 60000) // 1000, millis % 1000)
+
+    @staticmethod
+    def format_duration(micros):
+        # like EZLog::_writeDuration()
+        return str(micros) + "us" if micros < 10000 else str(micros // 1000) + "ms"
+
+    @staticmethod
+    def format_number(number):
+        digits = str(number)
+        length = len(digits)
+        if (length - 1) // 3 == 0:
+            return digits
+        first = length % 3 if length % 3 != 0 else 3
+        out = digits[:first]
+        if first != length:
+            out += "."
+        group = 0
+        for i in range(first, length):
+            out += digits[i]
+            group += 1
+            if group == 3 and i != length - 1:
+                out += "."
+                group = 0
+        return out
+
+    def render(self, line, name):
+        c = self.c
+        level = line["level"]
+        task_id = line["task"]
+        reset = c["RESET"] + self.bg_color(task_id)
+
+        color_idx = task_id - 1 if task_id <= len(self.task_colors) else 0
+        out = c["RESET"] + "[" + self.task_colors[color_idx] + str(task_id) + "] "
+        out += reset + c["WHITE"] + self.timestamp(line["timestamp"]) + " " + reset
+        out += self.prefix_colors[level] + LOGLEVEL_STRINGS[level] + reset
+        out += " " * (min(line["depth"], 20) * self.indent)  # like EZLog: at most 20 levels
+
+        if name:
+            parts = name.split("::")
+            cls = parts[0]
+            method = parts[1] if len(parts) > 1 else ""
+            start_stop_prefix, start_stop_suffix = "", ""
+            if line["start"]:
+                start_stop_prefix, start_stop_suffix = " ++ ", " - [START]"
+            elif line["end"]:
+                start_stop_prefix, start_stop_suffix = " -- ", " - [END]"
+            out += (c["YELLOW"] + start_stop_prefix + reset + c["GREEN"] + cls + reset + "::" + c["BLUE"] + method
+                    + c["YELLOW"] + start_stop_suffix + reset)
+            if not line["start"] and not line["end"]:
+                out += ": "
+
+        buffered = ""
+        if line["meminfo"] is not None:
+            heap, largest, psram = line["meminfo"]
+            buffered = (c["BRIGHT_YELLOW"] + " [ " + c["WHITE"] + self.format_number(heap) + " kB " + "("
+                        + c["CYAN"] + self.format_number(largest) + " kB" + c["WHITE"] + ")"
+                        + c["BRIGHT_YELLOW"] + " / " + c["WHITE"] + self.format_number(psram) + " kB "
+                        + c["BRIGHT_YELLOW"] + "] ")
+        buffered += line["partial"]
+
+        msg = line["message"]
+        if line["end"]:
+            if line["micros"]:
+                duration = self.format_duration(line["duration"])
+                if line["self"] is not None:
+                    duration += ", self " + self.format_duration(line["self"])
+            else:
+                duration = str(line["duration"]) + "ms"
+            msg = (c["RESET"] + " " + c["BRIGHT_BLACK"] + " (" + duration + ")" + c["RESET"])
+
+        out += reset + buffered + reset + self.text_colors[level] + msg + c["RESET"] + "\n"
+        return out
+
+
+def read_varint(data, pos):
+    value, shift = 0, 0
+    while True:
+        if pos >= len(data) or shift > 28:
+            raise ValueError("truncated varint")
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if not b & 0x80:
+            return value, pos
+        shift += 7
+
+
+class Decoder:
+    def __init__(self, renderer):
+        self.renderer = renderer
+        self.callsites = {}
+        self.pending = bytearray()
+
+    def feed(self, data):
+        """Decodes as much as possible, returns the rendered output as bytes"""
+        self.pending += data
+        out = bytearray()
+        buf = self.pending
+        pos = 0
+        while pos < len(buf):
+            sync = buf.find(SYNC, pos)
+            if sync < 0:
+                out += buf[pos:]
+                pos = len(buf)
+                break
+            out += buf[pos:sync]
+            pos = sync
+
+            try:
+                if pos + 2 >= len(buf):
+                    break  # wait for more data
+                record_type = buf[pos + 1]
+                length, payload_start = read_varint(buf, pos + 2)
+            except ValueError:
+                break  # wait for more data
+
+            if record_type not in (TYPE_CALLSITE, TYPE_LINE) or length > MAX_PAYLOAD:
+                out.append(buf[pos])  # not a record
+                pos += 1
+                continue
+            if payload_start + length > len(buf):
+                break  # wait for more data
+
+            payload = bytes(buf[payload_start:payload_start + length])
+            try:
+                out += self.handle_record(record_type, payload)
+            except (ValueError, IndexError):
+                out += buf[pos:payload_start + length]  # garbage: pass through
+            pos = payload_start + length
+
+        self.pending = buf[pos:]
+        return bytes(out)
+
+    def handle_record(self, record_type, payload):
+        callsite_id, pos = read_varint(payload, 0)
+        if record_type == TYPE_CALLSITE:
+            self.callsites[callsite_id] = payload[pos:].decode("utf-8", errors="replace")
+            return b""
+
+        timestamp, pos = read_varint(payload, pos)
+        task_id, depth, flags = payload[pos], payload[pos + 1], payload[pos + 2]
+        pos += 3
+        line = {
+            "timestamp": timestamp,
+            "task": task_id,
+            "depth": depth,
+            "level": min(flags & 0x07, 4),
+            "start": bool(flags & FLAG_START),
+            "end": bool(flags & FLAG_END),
+            "duration": 0,
+            "micros": bool(flags & FLAG_MICROS),
+            "self": None,
+            "meminfo": None,
+            "partial": "",
+        }
+        if line["end"]:
+            line["duration"], pos = read_varint(payload, pos)
+            if line["micros"]:
+                self_time, pos = read_varint(payload, pos)
+                line["self"] = self_time - 1 if self_time > 0 else None
+        if flags & FLAG_MEMINFO:
+            heap, pos = read_varint(payload, pos)
+            largest, pos = read_varint(payload, pos)
+            psram, pos = read_varint(payload, pos)
+            line["meminfo"] = (heap, largest, psram)
+        partial_len = 0
+        if flags & FLAG_PARTIAL:
+            partial_len, pos = read_varint(payload, pos)
+        text = payload[pos:].decode("utf-8", errors="replace")
+        line["partial"] = text[:partial_len]
+        line["message"] = text[partial_len:]
+
+        if callsite_id == 0:
+            # Table on the device was full (name was sent directly before) or line without prefix:
+            name = self.callsites.pop(0, "")
+        else:
+            name = self.callsites.get(callsite_id, "<callsite #%d>" % callsite_id)
+        return self.renderer.render(line, name).encode("utf-8")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decodes the binary output of EZLog")
+    parser.add_argument("file", nargs="?", help="binary capture file (default: stdin)")
+    parser.add_argument("--port", help="serial port to read from (needs pyserial)")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--no-color", action="store_true", help="output without ANSI colors (EZLOG_DISABLE_COLORS)")
+    parser.add_argument("--indent", type=int, default=4, help="spaces per nesting level (LoggingConfig::indentWidth)")
+    args = parser.parse_args()
+
+    decoder = Decoder(Renderer(colors=not args.no_color, indent=max(args.indent, 0)))
+    out = sys.stdout.buffer
+
+    if args.port:
+        import serial  # pylint: disable=import-outside-toplevel
+        source = serial.Serial(args.port, args.baud, timeout=0.1)
+        read = lambda: source.read(4096)  # noqa: E731
+    else:
+        source = open(args.file, "rb") if args.file else sys.stdin.buffer
+        read = lambda: source.read1(4096) if hasattr(source, "read1") else source.read(4096)  # noqa: E731
+
+    try:
+        while True:
+            data = read()
+            if not data and not args.port:
+                break
+            out.write(decoder.feed(data))
+            out.flush()
+    except KeyboardInterrupt:
+        pass
+    out.write(bytes(decoder.pending))
+
+
+if __name__ == "__main__":
+    main()